@@ -0,0 +1,11 @@
+# Builds the simulation core library, the headless tools and the unit tests on top of it:
+#   qmake headless.pro && make
+TEMPLATE = subdirs
+
+SUBDIRS = tankscore tankssim tankstests
+
+tankscore.file = tankscore.pro
+tankssim.file = tankssim.pro
+tankssim.depends = tankscore
+tankstests.file = tankstests.pro
+tankstests.depends = tankscore
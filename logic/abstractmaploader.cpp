@@ -6,4 +6,14 @@ AbstractMapLoader::AbstractMapLoader() { }
 
 AbstractMapLoader::~AbstractMapLoader() { }
 
+void AbstractMapLoader::setRandomSeed(quint64 seed) { Q_UNUSED(seed); }
+
+bool AbstractMapLoader::supportsRegions() const { return false; }
+
+QList<MapObject> AbstractMapLoader::loadRegion(const QRect &region)
+{
+    Q_UNUSED(region);
+    return QList<MapObject>();
+}
+
 } // namespace Tanks
@@ -44,6 +44,15 @@ public:
 
            // 獲取旗幟位置的虛擬函數
     virtual QPoint        flagPosition() const           = 0;
+
+           // 設置隨機種子的虛擬函數，確定性加載器可忽略
+    virtual void          setRandomSeed(quint64 seed);
+
+           // 是否支持按區域加載。支持時 Board 以分頁模式按需加載地圖，hasNext() 可直接返回 false
+    virtual bool             supportsRegions() const;
+
+           // 返回與 region（地圖塊坐標）相交的物體，裁剪到 region 內。同一區域必須返回相同結果
+    virtual QList<MapObject> loadRegion(const QRect &region);
 };
 
 } // namespace Tanks
@@ -4,11 +4,4 @@ namespace Tanks {
 
 AbstractPlayer::AbstractPlayer(QObject *parent) : QObject(parent) { }
 
-void AbstractPlayer::clockTick()
-{
-    if (_tank) {
-        _tank->clockTick();
-    }
-}
-
 } // namespace Tanks
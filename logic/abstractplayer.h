@@ -14,7 +14,7 @@ public:
     explicit AbstractPlayer(QObject *parent = 0);
     virtual int          lifesCount() const = 0;
     QSharedPointer<Tank> tank() const { return _tank; }
-    virtual void         clockTick();
+    virtual void         clockTick() = 0; // 坦克的時鐘由 EntityStore 統一推進
 
 signals:
     void newTankAvailable();
@@ -2,13 +2,12 @@
 #include "aiplayer.h"
 #include "board.h"
 #include "game.h"
-
-#include <QRandomGenerator>
+#include "randomstreams.h"
 
 namespace Tanks {
 
 // AI 類的構造函數
-AI::AI(Game *game) : QObject(game), _game(game), _activateClock(0) { }
+AI::AI(Game *game) : QObject(game), _game(game), _activateClock(0), _playersLimit(8), _activationInterval(100) { }
 
 // AI 類的析構函數
 AI::~AI() { reset(); }
@@ -17,8 +16,12 @@ AI::~AI() { reset(); }
 void AI::reset()
 {
     _activePlayers.clear(); // 清除活躍的 AI 玩家列表
+    _activeIndex.fill(-1);
     _inactivePlayers.clear(); // 清除不活躍的 AI 玩家列表
     _tanks.clear(); // 清除坦克列表
+    foreach (auto p, _players) {
+        p->reset(); // 銷毀上一局的坦克，隨機數流在 start() 中設置
+    }
     _activateClock = 0; // 重置激活時鐘
 }
 
@@ -26,31 +29,28 @@ void AI::reset()
 void AI::start()
 {
     _tanks = _game->board()->initialEnemyTanks();
-    for (int i = 0; i < 8; i++) { // 同時在地圖上最多顯示 4 個坦克
-        auto robot = QSharedPointer<AIPlayer>(new AIPlayer(this));
-        _inactivePlayers.push_back(robot);
+    _rng   = RandomStreams::generator(_game->seed(), RandomStreams::AIStream);
+    for (int i = 0; i < _playersLimit; i++) { // 同時在地圖上最多顯示的坦克數
+        auto rng = RandomStreams::generator(_game->seed(), RandomStreams::AIPlayerStream + i);
+        _inactivePlayers.push_back(i);
+        if (i < _players.count()) { // 重用上一局的玩家，信號連接保持不變
+            _players[i]->setRandomGenerator(rng);
+            continue;
+        }
+        auto robot = QSharedPointer<AIPlayer>(new AIPlayer(this, rng));
+        _players.append(robot);
+        _activeIndex.append(-1);
 
-        connect(robot.data(), &AIPlayer::lifeLost, this, &AI::deactivatePlayer);
+        connect(robot.data(), &AIPlayer::lifeLost, this, [this, i]() { deactivatePlayer(i); });
         emit newPlayer(robot.data());
     }
 }
 
-// 查找和指定塊發生碰撞的 AI 玩家的函數
-QSharedPointer<AIPlayer> AI::findClash(const QSharedPointer<Block> &block)
-{
-    foreach (auto p, _activePlayers) {
-        if (p->tank() && p->tank()->hasClash(*block)) {
-            return p;
-        }
-    }
-    return QSharedPointer<AIPlayer>();
-}
-
 // 獲取 AI 玩家的初始位置的函數
-QPoint AI::initialPosition() const
+QPoint AI::initialPosition()
 {
     auto &pos = _game->board()->enemyStartPositions();
-    return pos.value(QRandomGenerator::global()->bounded(pos.count()));
+    return pos.value(_rng.bounded(pos.count()));
 }
 
 // 時間流逝的處理函數，控制 AI 玩家的行為
@@ -60,30 +60,38 @@ void AI::clockTick()
         _activateClock--;
     }
     if (!_activateClock && !_inactivePlayers.empty() && _tanks.count()) {
-        auto player = _inactivePlayers.front();
-        _inactivePlayers.pop_front();
-        _activePlayers.push_back(player);
-        player->start();
-        _activateClock = 100;
+        QPoint pos = initialPosition();
+        if (!_game->board()->occupant(QRect(pos, Tank::size()))) { // 出生點被佔據時下個週期再試
+            int player = _inactivePlayers.front();
+            _inactivePlayers.pop_front();
+            _activeIndex[player] = _activePlayers.size();
+            _activePlayers.append(player);
+            _players.at(player)->start(pos);
+            _activateClock = _activationInterval;
+        }
     }
 
-    for (auto &p : _activePlayers) {
-        p->clockTick();
+    foreach (int player, _activePlayers) {
+        _players.at(player)->clockTick();
     }
 }
 
-// 停用 AI 玩家的函數
-void AI::deactivatePlayer()
+// 停用 AI 玩家的函數，最後一個活躍玩家填補它的位置
+void AI::deactivatePlayer(int player)
 {
-    auto it = _activePlayers.begin();
-    while (it != _activePlayers.end()) {
-        if ((*it).data() == sender()) {
-            _inactivePlayers.push_back(*it);
-            _activePlayers.erase(it);
-            break;
-        }
-        ++it;
+    int i = _activeIndex.value(player, -1);
+    if (i < 0) {
+        return;
+    }
+    _activeIndex[player] = -1;
+    _inactivePlayers.push_back(player);
+
+    int last = _activePlayers.size() - 1;
+    if (i != last) {
+        _activePlayers[i]                  = _activePlayers.at(last);
+        _activeIndex[_activePlayers.at(i)] = i;
     }
+    _activePlayers.removeLast();
 }
 
 } // namespace Tanks
@@ -4,6 +4,8 @@
 #include "aiplayer.h"
 
 #include <QObject>
+#include <QRandomGenerator>
+#include <QVector>
 
 #include <list>
 
@@ -31,19 +33,20 @@ public:
     inline int pendingTanks() const { return _tanks.count(); }
 
            // 獲取 AI 生命值的數量
-    inline int lifesCount() const { return _tanks.count() + _activePlayers.size(); }
+    inline int lifesCount() const { return _tanks.count() + _activePlayers.count(); }
 
            // 取出一個坦克類型
     inline quint8 takeTank() { return _tanks.takeFirst(); }
 
+           // 同時活躍的 AI 玩家上限及兩次出場之間的週期數
+    inline void setPlayersLimit(int limit) { _playersLimit = qMax(1, limit); }
+    inline void setActivationInterval(int ticks) { _activationInterval = qMax(1, ticks); }
+
            // 啟動 AI 的函數
     void start();
 
-           // 尋找與指定塊發生碰撞的 AI 玩家
-    QSharedPointer<AIPlayer> findClash(const QSharedPointer<Block> &block);
-
            // 獲取初始位置的函數
-    QPoint initialPosition() const;
+    QPoint initialPosition();
 
            // 時間流逝的處理函數，控制 AI 的行為
     void clockTick();
@@ -54,16 +57,20 @@ signals:
 
 public slots:
 
-private slots:
-    // 停用玩家的槽函數
-    void deactivatePlayer();
-
 private:
+    // 停用編號為 player 的玩家
+    void deactivatePlayer(int player);
+
     Game                               *_game; // 指向 Game 類實例的指針
     QList<quint8>                       _tanks; // 存儲坦克類型的列表
-    std::list<QSharedPointer<AIPlayer>> _activePlayers; // 存儲活躍的 AI 玩家
-    std::list<QSharedPointer<AIPlayer>> _inactivePlayers; // 存儲非活躍的 AI 玩家
+    QList<QSharedPointer<AIPlayer>>     _players; // 所有創建過的 AI 玩家，跨局重用，下標即玩家編號
+    QVector<int>                        _activePlayers; // 活躍玩家的編號，緊湊存放
+    QVector<int>                        _activeIndex; // 按編號：在 _activePlayers 中的位置，不活躍時為 -1
+    std::list<int>                      _inactivePlayers; // 非活躍玩家的編號，按出場順序
     int                                 _activateClock; // 控制 AI 玩家激活的計時器
+    int                                 _playersLimit; // AI 玩家數量上限
+    int                                 _activationInterval; // 出場間隔
+    QRandomGenerator                    _rng; // AI 獨立的隨機數流
 };
 
 } // namespace Tanks
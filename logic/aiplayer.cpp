@@ -5,31 +5,35 @@
 #include "game.h"
 
 #include <QDebug>
-#include <QRandomGenerator>
 
 namespace Tanks {
 
 // AIPlayer 類的構造函數
-AIPlayer::AIPlayer(AI *ai) : _ai(ai) { }
+AIPlayer::AIPlayer(AI *ai, const QRandomGenerator &rng) : _ai(ai), _rng(rng) { }
 
 // 獲取 AI 玩家生命值的函數
 int AIPlayer::lifesCount() const { return _ai->pendingTanks(); }
 
 // 啟動 AI 玩家的函數
-void AIPlayer::start()
+void AIPlayer::start(const QPoint &position)
 {
     // 創建一個新的 AI 控制的坦克
-    _tank = QSharedPointer<Tank>(new Tank(Alien, _ai->takeTank()));
-    _tank->setInitialPosition(_ai->initialPosition());
+    _tank = QSharedPointer<Tank>(new Tank(_ai->game()->entities(), Alien, _ai->takeTank()));
+    _tank->setInitialPosition(position);
+    _ai->game()->board()->addOccupant(_tank.data());
     emit newTankAvailable();
     connect(_tank.data(), &Tank::tankDestroyed, this, &AIPlayer::onTankDestroyed);
 }
 
+// 重置 AI 玩家的函數
+void AIPlayer::reset() { _tank.clear(); }
+
+// 更換隨機數流的函數
+void AIPlayer::setRandomGenerator(const QRandomGenerator &rng) { _rng = rng; }
+
 // 時間流逝的處理函數，控制 AI 玩家的行為
 void AIPlayer::clockTick()
 {
-    AbstractPlayer::clockTick();
-
     if (!_tank) {
         return; // 如果沒有坦克，則不執行任何操作
     }
@@ -38,18 +42,20 @@ void AIPlayer::clockTick()
 
            // 決定坦克的移動和射擊行為
     if (_tank->canMove()) {
-        Board::BlockProps props          = _ai->game()->board()->rectProps(_tank->forwardMoveRect());
-        bool              canMoveForward = !(props & Board::TankObstackle);
+        Board            *board          = _ai->game()->board();
+        QRect             fmr            = _tank->forwardMoveRect();
+        Board::BlockProps props          = board->rectProps(fmr);
+        bool              canMoveForward = !(props & Board::TankObstackle) && !board->occupant(fmr, _tank.data());
 
-        int r = QRandomGenerator::global()->bounded(16);
-        int d = QRandomGenerator::global()->bounded(16);
+        int r = _rng.bounded(16);
+        int d = _rng.bounded(16);
 
         bool moving     = r < 15;
         bool needNewDir = !canMoveForward || d > 13;
 
         if (needNewDir) {
             if (_ai->game()->flag()->isBroken()) {
-                _tank->setDirection((Direction)(QRandomGenerator::global()->bounded(4)));
+                _tank->setDirection((Direction)(_rng.bounded(4)));
             } else {
                 QPoint    tc = _tank->geometry().center();
                 QPoint    fc = _ai->game()->flag()->geometry().center();
@@ -70,17 +76,20 @@ void AIPlayer::clockTick()
                 }
 
                 int toFlagInd
-                    = QRandomGenerator::global()->generate() < (std::numeric_limits<quint32>::max() * 0.9) ? 0 : 2;
+                    = _rng.generate() < (std::numeric_limits<quint32>::max() * 0.9) ? 0 : 2;
                 Direction newDir = dirs[toFlagInd + (d & 1)];
 
                 _tank->setDirection(newDir);
             }
-            props          = _ai->game()->board()->rectProps(_tank->forwardMoveRect());
-            canMoveForward = !(props & Board::TankObstackle);
+            fmr            = _tank->forwardMoveRect();
+            props          = board->rectProps(fmr);
+            canMoveForward = !(props & Board::TankObstackle) && !board->occupant(fmr, _tank.data());
         }
 
         if (canMoveForward && moving) {
+            QRect from = _tank->geometry();
             _tank->move();
+            board->moveOccupant(_tank.data(), from);
         } else if (props & Board::Breakable && !(props & Board::Sturdy)) {
             forceShoot = true;
         }
@@ -92,7 +101,7 @@ void AIPlayer::clockTick()
 
            // 決定是否射擊
     if (_tank->canShoot()) {
-        if (forceShoot || QRandomGenerator::global()->generate() < std::numeric_limits<quint32>::max() / 100) {
+        if (forceShoot || _rng.generate() < std::numeric_limits<quint32>::max() / 100) {
             _tank->fire();
         }
     }
@@ -101,6 +110,7 @@ void AIPlayer::clockTick()
 // 坦克被摧毀時的處理函數
 void AIPlayer::onTankDestroyed()
 {
+    _ai->game()->board()->removeOccupant(_tank.data());
     _tank.clear();
     emit lifeLost();
 }
@@ -31,22 +31,27 @@
 #include "abstractplayer.h"
 #include "tank.h"
 
+#include <QRandomGenerator>
+
 namespace Tanks {
 
 class AI;
 
 class AIPlayer : public AbstractPlayer {
 public:
-    AIPlayer(AI *ai);
+    AIPlayer(AI *ai, const QRandomGenerator &rng);
     int lifesCount() const;
 
-    void start();
+    void start(const QPoint &position);
     void clockTick();
+    void reset(); // 新一局前清除坦克
+    void setRandomGenerator(const QRandomGenerator &rng); // 新一局開始時換用該局的隨機數流
 private slots:
     void onTankDestroyed();
 
 private:
-    AI *_ai;
+    AI              *_ai;
+    QRandomGenerator _rng; // 本玩家獨立的隨機數流
 };
 
 } // namespace Tanks
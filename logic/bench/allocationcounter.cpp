@@ -0,0 +1,65 @@
+#include "benchharness.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// 計算進程中的堆分配次數。Qt 容器直接使用 malloc，因此在 glibc 上攔截 malloc 本身；
+// 其他平台退而只計算 operator new。
+
+namespace {
+std::atomic<quint64> allocationCounter(0);
+}
+
+namespace Tanks {
+quint64 benchAllocations() { return allocationCounter.load(std::memory_order_relaxed); }
+} // namespace Tanks
+
+#if defined(__GLIBC__)
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+    allocationCounter.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    allocationCounter.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    allocationCounter.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+}
+
+#else
+
+void *operator new(std::size_t size)
+{
+    allocationCounter.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete[](void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+#endif
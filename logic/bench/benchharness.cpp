@@ -0,0 +1,119 @@
+#include "benchharness.h"
+
+#include <QHash>
+#include <QJsonArray>
+#include <QStringList>
+
+namespace Tanks {
+
+BenchState::BenchState(qint64 iterations, int arg) :
+    _iterations(iterations), _done(0), _arg(arg), _running(false), _since(0), _allocSince(0), _elapsedNs(0),
+    _allocations(0)
+{
+    _timer.start();
+}
+
+// 測量循環條件，首次呼叫時開始計時
+bool BenchState::keepRunning()
+{
+    if (_done == 0 && !_running) {
+        resume();
+    }
+    if (_done < _iterations) {
+        _done++;
+        return true;
+    }
+    pause();
+    return false;
+}
+
+// 暫停計時與分配計數
+void BenchState::pause()
+{
+    if (!_running) {
+        return;
+    }
+    _elapsedNs += _timer.nsecsElapsed() - _since;
+    _allocations += benchAllocations() - _allocSince;
+    _running = false;
+}
+
+// 恢復計時與分配計數
+void BenchState::resume()
+{
+    if (_running) {
+        return;
+    }
+    _running    = true;
+    _allocSince = benchAllocations();
+    _since      = _timer.nsecsElapsed();
+}
+
+void BenchRunner::add(const QString &name, const Function &fn, int arg) { _entries.append(Entry { name, fn, arg }); }
+
+// 逐一執行基準測試，自動調整迭代次數直到總時間超過下限
+QList<BenchResult> BenchRunner::run()
+{
+    QList<BenchResult> results;
+    for (const auto &e : _entries) {
+        if (!_filter.isEmpty() && !e.name.contains(_filter)) {
+            continue;
+        }
+        qint64 iterations = 1;
+        for (;;) {
+            BenchState state(iterations, e.arg);
+            e.fn(state);
+            qint64 elapsed = qMax(qint64(1), state.elapsedNs());
+            if (elapsed >= _minTimeNs || iterations >= (qint64(1) << 30)) {
+                BenchResult r;
+                r.name        = e.name;
+                r.iterations  = iterations;
+                r.nsPerOp     = double(elapsed) / iterations;
+                r.allocsPerOp = double(state.allocations()) / iterations;
+                results.append(r);
+                break;
+            }
+            double factor = qBound(2.0, 1.4 * _minTimeNs / elapsed, 100.0);
+            iterations    = qint64(iterations * factor);
+        }
+    }
+    return results;
+}
+
+// 轉為 JSON 物件
+QJsonObject BenchRunner::toJson(const QList<BenchResult> &results)
+{
+    QJsonArray list;
+    for (const auto &r : results) {
+        QJsonObject o;
+        o.insert("name", r.name);
+        o.insert("iterations", r.iterations);
+        o.insert("ns_per_op", r.nsPerOp);
+        o.insert("allocs_per_op", r.allocsPerOp);
+        list.append(o);
+    }
+    QJsonObject root;
+    root.insert("benchmarks", list);
+    return root;
+}
+
+// 與基準結果比較，找出變慢超過閾值的項目
+QStringList BenchRunner::compare(const QList<BenchResult> &results, const QJsonObject &baseline, double threshold)
+{
+    QHash<QString, double> base;
+    for (const auto &v : baseline.value("benchmarks").toArray()) {
+        QJsonObject o = v.toObject();
+        base.insert(o.value("name").toString(), o.value("ns_per_op").toDouble());
+    }
+
+    QStringList regressions;
+    for (const auto &r : results) {
+        double b = base.value(r.name, 0.0);
+        if (b > 0 && r.nsPerOp > b * (1.0 + threshold / 100.0)) {
+            regressions.append(r.name);
+        }
+    }
+    return regressions;
+}
+
+} // namespace Tanks
@@ -0,0 +1,110 @@
+/*
+ Copyright (c) 2016, Sergey Ilinykh
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL IL'INYKH SERGEY BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef TANKS_BENCHHARNESS_H
+#define TANKS_BENCHHARNESS_H
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+
+#include <functional>
+
+namespace Tanks {
+
+// total number of heap allocations made by the process so far
+quint64 benchAllocations();
+
+/**
+ * @brief The BenchState class
+ * Drives the measured loop of one benchmark:
+ *     while (state.keepRunning()) { ...op... }
+ * Work between pause() and resume() is neither timed nor counted.
+ */
+class BenchState {
+public:
+    BenchState(qint64 iterations, int arg);
+
+    bool keepRunning();
+    void pause();
+    void resume();
+
+    inline int    arg() const { return _arg; }
+    inline qint64 iterations() const { return _iterations; }
+    inline qint64 elapsedNs() const { return _elapsedNs; }
+    inline qint64 allocations() const { return _allocations; }
+
+private:
+    QElapsedTimer _timer;
+    qint64        _iterations;
+    qint64        _done;
+    int           _arg;
+    bool          _running;
+    qint64        _since;
+    quint64       _allocSince;
+    qint64        _elapsedNs;
+    qint64        _allocations;
+};
+
+struct BenchResult {
+    QString name;
+    qint64  iterations   = 0;
+    double  nsPerOp      = 0;
+    double  allocsPerOp  = 0;
+};
+
+class BenchRunner {
+public:
+    typedef std::function<void(BenchState &)> Function;
+
+    void add(const QString &name, const Function &fn, int arg = 0);
+
+    void setFilter(const QString &filter) { _filter = filter; }
+    void setMinTimeMs(int ms) { _minTimeNs = qint64(ms) * 1000000; }
+
+    QList<BenchResult> run();
+
+    static QJsonObject toJson(const QList<BenchResult> &results);
+    // returns names of benchmarks which got slower than baseline by more than threshold percent
+    static QStringList compare(const QList<BenchResult> &results, const QJsonObject &baseline, double threshold);
+
+private:
+    struct Entry {
+        QString  name;
+        Function fn;
+        int      arg;
+    };
+    QList<Entry> _entries;
+    QString      _filter;
+    qint64       _minTimeNs = 300000000;
+};
+
+} // namespace Tanks
+
+#endif // TANKS_BENCHHARNESS_H
@@ -0,0 +1,322 @@
+#include "ai.h"
+#include "benchharness.h"
+#include "board.h"
+#include "bullet.h"
+#include "entitystore.h"
+#include "game.h"
+#include "qmlbridge.h"
+#include "randommaploader.h"
+#include "randomstreams.h"
+
+#include <QCommandLineParser>
+#include <QFile>
+#include <QGuiApplication>
+#include <QJsonDocument>
+#include <QTextStream>
+
+namespace Tanks {
+
+// 存取 Game 私有成員的基準測試輔助類
+class GameBenchmark {
+public:
+    static void moveBullets(Game &game) { game.moveBullets(); }
+};
+
+} // namespace Tanks
+
+using namespace Tanks;
+
+namespace {
+
+const quint64 benchSeed = 20161125; // 固定種子，保證輸入可重現
+volatile int  sink; // 防止編譯器優化掉被測代碼
+
+// 在棋盤內生成固定序列的矩形
+QVector<QRect> makeRects(const QSize &boardSize, int count, const QSize &rectSize)
+{
+    QRandomGenerator rng = RandomStreams::generator(benchSeed, 100);
+    QVector<QRect>   rects;
+    rects.reserve(count);
+    for (int i = 0; i < count; i++) {
+        QPoint tl(rng.bounded(boardSize.width() - rectSize.width() + 1),
+                  rng.bounded(boardSize.height() - rectSize.height() + 1));
+        rects.append(QRect(tl, rectSize));
+    }
+    return rects;
+}
+
+// 準備一局手動時鐘的遊戲並完成地圖加載
+void prepareGame(Game &game)
+{
+    game.setManualClock(true);
+    game.setSeed(benchSeed);
+    game.start(1);
+    game.step(0);
+}
+
+void benchRectProps(BenchState &state)
+{
+    Board           board;
+    RandomMapLoader loader;
+    loader.setRandomSeed(benchSeed);
+    board.loadMap(&loader);
+    QVector<QRect> rects = makeRects(board.size(), 4096, QSize(4, 4));
+
+    int i = 0, acc = 0;
+    while (state.keepRunning()) {
+        acc += int(board.rectProps(rects[i++ & 4095]));
+    }
+    sink = acc;
+}
+
+void benchRectPropsLarge(BenchState &state)
+{
+    Board           board;
+    RandomMapLoader loader;
+    loader.setRandomSeed(benchSeed);
+    board.setAreaIndexEnabled(state.arg());
+    board.loadMap(&loader);
+    QVector<QRect> rects = makeRects(board.size(), 4096, QSize(32, 32));
+
+    int i = 0, acc = 0;
+    while (state.keepRunning()) {
+        acc += int(board.rectProps(rects[i++ & 4095]));
+    }
+    sink = acc;
+}
+
+void benchRenderBlock(BenchState &state)
+{
+    Board           board;
+    RandomMapLoader loader;
+    loader.setRandomSeed(benchSeed);
+    board.loadMap(&loader);
+    QVector<QRect> rects = makeRects(board.size(), 4096, QSize(4, 4));
+
+    int i = 0;
+    while (state.keepRunning()) {
+        board.renderBlock(i & 1 ? Brick : Nothing, rects[i & 4095]);
+        i++;
+    }
+}
+
+// 每批 64 個 1x1 矩形，相當於一串爆炸或橢圓邊緣
+void benchRenderBlocks(BenchState &state)
+{
+    Board           board;
+    RandomMapLoader loader;
+    loader.setRandomSeed(benchSeed);
+    board.loadMap(&loader);
+    QVector<QRect>          rects = makeRects(board.size(), 4096, QSize(1, 1));
+    QVector<QVector<QRect>> batches;
+    for (int i = 0; i < rects.size(); i += 64) {
+        batches.append(rects.mid(i, 64));
+    }
+
+    int i = 0;
+    while (state.keepRunning()) {
+        board.renderBlocks(i & 1 ? Brick : Nothing, batches[i & 63]);
+        i++;
+    }
+}
+
+// 整張地圖掃描：arg 為 0 時逐格，為 1 時按段
+void benchBoardScan(BenchState &state)
+{
+    Board           board;
+    RandomMapLoader loader;
+    loader.setRandomSeed(benchSeed);
+    board.loadMap(&loader);
+
+    int acc = 0;
+    while (state.keepRunning()) {
+        if (state.arg()) {
+            for (Board::RunIterator it = board.runs(); it.isValid(); ++it) {
+                acc += it->type * it->length;
+            }
+        } else {
+            for (Board::Iterator it = board.iterate(); it.isValid(); ++it) {
+                acc += *it;
+            }
+        }
+    }
+    sink = acc;
+}
+
+// 快照、修改一小塊、恢復：AI 預測和回滾的典型用法
+void benchSnapshot(BenchState &state)
+{
+    Board           board;
+    RandomMapLoader loader;
+    loader.setRandomSeed(benchSeed);
+    board.loadMap(&loader);
+    QVector<QRect> rects = makeRects(board.size(), 4096, QSize(4, 4));
+
+    int i = 0;
+    while (state.keepRunning()) {
+        Board::Snapshot s = board.snapshot();
+        board.renderBlock(Nothing, rects[i++ & 4095]);
+        board.restore(s);
+    }
+}
+
+void benchMoveBullets(BenchState &state)
+{
+    Game game;
+    prepareGame(game);
+    QRandomGenerator rng   = RandomStreams::generator(benchSeed, 101);
+    QSize            size  = game.board()->size();
+    const int        count = state.arg();
+    game.board()->renderBlock(Nothing, QRect(QPoint(0, 0), size)); // 空棋盤，子彈存活更久
+
+    while (state.keepRunning()) {
+        state.pause();
+        while (game.liveBullets() < count) { // 補足離開棋盤或爆炸的子彈
+            Bullet bullet(rng.bounded(2) ? Alien : Friendly, Bullet::Regular);
+            bullet.position  = QPoint(rng.bounded(size.width() - 2), rng.bounded(size.height() - 2));
+            bullet.direction = Direction(rng.bounded(4));
+            game.addBullet(bullet);
+        }
+        state.resume();
+        GameBenchmark::moveBullets(game);
+    }
+}
+
+void benchAIClockTick(BenchState &state)
+{
+    Game game;
+    auto loader = new RandomMapLoader();
+    loader->setEnemyTanksCount(100000);
+    game.setMapLoader(loader);
+    game.ai()->setPlayersLimit(state.arg());
+    game.ai()->setActivationInterval(1);
+    prepareGame(game);
+    game.step(state.arg()); // 讓所有 AI 玩家出場
+
+    int i = 0;
+    while (state.keepRunning()) {
+        game.entities()->clockTick(); // 坦克的時鐘由 Game 在 AI 之前推進
+        game.ai()->clockTick();
+        if (!(++i & 63)) { // 定期清理子彈，避免無限累積
+            state.pause();
+            GameBenchmark::moveBullets(game);
+            state.resume();
+        }
+    }
+}
+
+void benchMapLoad(BenchState &state)
+{
+    Board           board;
+    RandomMapLoader loader;
+    while (state.keepRunning()) {
+        loader.setRandomSeed(benchSeed);
+        board.loadMap(&loader);
+    }
+}
+
+// 重新開始一局直到地圖就緒，玩家和 AI 物件被重用
+void benchRestart(BenchState &state)
+{
+    Game game;
+    prepareGame(game);
+    while (state.keepRunning()) {
+        game.start(2);
+        game.step(0);
+    }
+}
+
+void benchBridgeMapLoaded(BenchState &state)
+{
+    QMLBridge bridge;
+    while (state.keepRunning()) {
+        QMetaObject::invokeMethod(&bridge, "mapLoaded", Qt::DirectConnection);
+    }
+}
+
+// 基準測試期間丟棄除錯輸出
+void quietMessageHandler(QtMsgType type, const QMessageLogContext &, const QString &msg)
+{
+    if (type != QtDebugMsg) {
+        QTextStream(stderr) << msg << "\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen"); // 地圖光柵化需要 QGuiApplication，但不需要顯示器
+    }
+    QGuiApplication app(argc, argv);
+    QCoreApplication::setApplicationName("tanksbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Microbenchmarks of the engine hot paths");
+    parser.addHelpOption();
+    QCommandLineOption jsonOption("json", "Write results to <file> instead of stdout.", "file");
+    QCommandLineOption baselineOption("baseline", "Compare against results stored in <file>.", "file");
+    QCommandLineOption thresholdOption("threshold", "Allowed slowdown against baseline in percent.", "percent", "10");
+    QCommandLineOption filterOption("filter", "Run only benchmarks whose name contains <text>.", "text");
+    QCommandLineOption minTimeOption("min-time", "Minimal measured time per benchmark.", "ms", "300");
+    parser.addOption(jsonOption);
+    parser.addOption(baselineOption);
+    parser.addOption(thresholdOption);
+    parser.addOption(filterOption);
+    parser.addOption(minTimeOption);
+    parser.process(app);
+
+    BenchRunner runner;
+    runner.setFilter(parser.value(filterOption));
+    runner.setMinTimeMs(qMax(1, parser.value(minTimeOption).toInt()));
+    runner.add("board/rectProps", benchRectProps);
+    runner.add("board/rectProps/32x32", benchRectPropsLarge, 0);
+    runner.add("board/rectProps/32x32/areaIndex", benchRectPropsLarge, 1);
+    runner.add("board/renderBlock", benchRenderBlock);
+    runner.add("board/renderBlocks/64", benchRenderBlocks);
+    runner.add("board/scan/cells", benchBoardScan, 0);
+    runner.add("board/scan/runs", benchBoardScan, 1);
+    runner.add("board/snapshot", benchSnapshot);
+    runner.add("game/moveBullets/10", benchMoveBullets, 10);
+    runner.add("game/moveBullets/100", benchMoveBullets, 100);
+    runner.add("game/moveBullets/1000", benchMoveBullets, 1000);
+    runner.add("ai/clockTick/64", benchAIClockTick, 64);
+    runner.add("map/load", benchMapLoad);
+    runner.add("game/restart", benchRestart);
+    runner.add("bridge/mapLoaded", benchBridgeMapLoaded);
+
+    qInstallMessageHandler(quietMessageHandler);
+    QList<BenchResult> results = runner.run();
+    qInstallMessageHandler(nullptr);
+
+    QByteArray json = QJsonDocument(BenchRunner::toJson(results)).toJson();
+    if (parser.isSet(jsonOption)) {
+        QFile f(parser.value(jsonOption));
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qWarning() << "Failed to write" << parser.value(jsonOption) << f.errorString();
+            return 2;
+        }
+        f.write(json);
+    } else {
+        QTextStream(stdout) << json;
+    }
+
+    if (parser.isSet(baselineOption)) {
+        QFile f(parser.value(baselineOption));
+        if (!f.open(QIODevice::ReadOnly)) {
+            qWarning() << "Failed to read" << parser.value(baselineOption) << f.errorString();
+            return 2;
+        }
+        QJsonObject baseline    = QJsonDocument::fromJson(f.readAll()).object();
+        double      threshold   = parser.value(thresholdOption).toDouble();
+        QStringList regressions = BenchRunner::compare(results, baseline, threshold);
+        for (const auto &name : regressions) {
+            QTextStream(stderr) << "REGRESSION: " << name << " is more than " << threshold << "% slower\n";
+        }
+        if (!regressions.isEmpty()) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -3,15 +3,68 @@
 #include "staticblock.h"
 #include "tank.h"
 
+#include <QDebug>
 #include <QTimer>
+#include <QtMath>
+#include <QtAlgorithms>
 
 namespace Tanks {
 
 // 地圖縮放因子，用於更細分的塊管理
 #define MAP_SCALE_FACTOR 2
 
+// 以位平面維護的屬性，順序即平面順序
+static const Board::BlockProp planeProps[] = {
+    Board::TankObstackle, Board::BulletObstackle, Board::Sturdy, Board::Breakable, Board::BadManoeuvre
+};
+static const int planesCount = sizeof(planeProps) / sizeof(planeProps[0]);
+static_assert(planesCount == ChunkedMap::PlanesCount, "every plane property needs a ChunkedMap plane");
+
+// 超過此面積的查詢改用面積和表
+static const int areaIndexMinCells = 256;
+
+// 髒區域記錄的上限，以及新矩形嘗試與之合併的最近記錄數
+static const int maxDirtyRects   = 1024;
+static const int dirtyMergeDepth = 4;
+
+// 兩個矩形的並集恰為矩形時合併到 a
+static bool uniteExactly(QRect &a, const QRect &b)
+{
+    if (a.contains(b)) {
+        return true;
+    }
+    if (b.contains(a)) {
+        a = b;
+        return true;
+    }
+    bool rows = a.top() == b.top() && a.bottom() == b.bottom() // 同一行帶，且相交或相鄰
+        && b.left() <= a.right() + 1 && a.left() <= b.right() + 1;
+    bool columns = a.left() == b.left() && a.right() == b.right() // 同一列帶，且相交或相鄰
+        && b.top() <= a.bottom() + 1 && a.top() <= b.bottom() + 1;
+    if (rows || columns) {
+        a |= b;
+        return true;
+    }
+    return false;
+}
+
 // Board 類的構造函數
-Board::Board(QObject *parent) : QObject(parent) { }
+Board::Board(QObject *parent) :
+    QObject(parent), _regionLoader(nullptr), _memoryBudget(64 * 1024 * 1024), _pageClock(0), _version(0),
+    _dirtyFloor(0), _mapId(0), _areaIndexEnabled(false)
+{
+    quint8 typePlanes[LastMapObjectType];
+    for (int t = 0; t < LastMapObjectType; t++) {
+        BlockProps props = blockTypeProperties(MapObjectType(t));
+        typePlanes[t]    = 0;
+        for (int p = 0; p < planesCount; p++) {
+            if (props & planeProps[p]) {
+                typePlanes[t] |= 1 << p;
+            }
+        }
+    }
+    _map.setTypePlanes(typePlanes);
+}
 
 // 加載地圖的函數
 bool Board::loadMap(AbstractMapLoader *loader)
@@ -21,21 +74,34 @@ bool Board::loadMap(AbstractMapLoader *loader)
     }
 
            // 初始化棋盤尺寸和地圖
-    _size = loader->dimensions() * MAP_SCALE_FACTOR;
-    _size = _size.boundedTo(QSize(1024, 1024));
+    _size         = loader->dimensions() * MAP_SCALE_FACTOR;
+    _regionLoader = loader->supportsRegions() ? loader : nullptr;
+    if (!_regionLoader && ChunkedMap::worstCaseBytes(_size) > _memoryBudget) {
+        // 一次性加載的地圖按預算等比縮小
+        double f = qSqrt(double(_memoryBudget) / ChunkedMap::worstCaseBytes(_size));
+        _size    = QSize(qMax(1, int(_size.width() * f)), qMax(1, int(_size.height() * f)));
+        qWarning("Map is cropped to %dx%d to fit the memory budget", _size.width(), _size.height());
+    }
     QRect boardRect(QPoint(0, 0), _size);
-    _map.resize(_size.width() * _size.height());
-    _map.fill(0);
+    _map.reset(_size, _regionLoader ? ChunkedMap::Missing : ChunkedMap::Dirty);
+    _pageClock = 0;
+    if (_areaIndexEnabled && _regionLoader) {
+        qWarning("Area index is not available for paged boards");
+        setAreaIndexEnabled(false);
+    }
+    if (_areaIndexEnabled) {
+        _areaIndex.resize(planesCount * (_size.width() + 1) * (_size.height() + 1));
+        _areaIndex.fill(0); // 第 0 行和第 0 列必須為零
+        invalidateAreaIndex(QPoint(0, 0));
+    }
 
-           // 加載地圖物件
-    while (loader->hasNext()) {
+           // 加載地圖物件，分頁模式下由 pageIn() 按需加載。整張地圖在最後才記為已變化，
+    // 面積和表也已整體失效，所以直接寫入存儲
+    _map.beginBatch();
+    while (!_regionLoader && loader->hasNext()) {
         MapObject block = loader->next();
         QRect     cropped(block.geometry.topLeft() * MAP_SCALE_FACTOR, block.geometry.size() * MAP_SCALE_FACTOR);
-        cropped &= boardRect;
-        if (cropped.isEmpty()) {
-            continue;
-        }
-        renderBlock(block.type, cropped);
+        _map.fill(cropped & boardRect, block.type);
     }
 
            // 設置旗幟位置並渲染旗幟框架
@@ -44,7 +110,10 @@ bool Board::loadMap(AbstractMapLoader *loader)
     renderFlagFrame(Brick);
 
            // 設置敵方和友方坦克的起始位置
+    _occupancy.clear(); // 坦克在新地圖上重新出場
     _initialEnemyTanks = loader->enemyTanks();
+    _enemyStartPositions.clear(); // 重新開始時不能累積上一局的位置
+    _friendlyStartPositions.clear();
     foreach (const QPoint &p, loader->enemyStartPositions()) {
         QPoint sp = p * MAP_SCALE_FACTOR;
         _enemyStartPositions.append(sp);
@@ -55,7 +124,12 @@ bool Board::loadMap(AbstractMapLoader *loader)
         _friendlyStartPositions.append(sp);
         renderBlock(Nothing, QRect(sp, QSize(4, 4)));
     }
+    _map.endBatch();
 
+           // 新地圖整體視為已變化，之前的記錄都失效
+    _dirty.clear();
+    _dirtyFloor = ++_version;
+    _mapId++;
     return true;
 }
 
@@ -66,12 +140,207 @@ void Board::renderBlock(MapObjectType type, const QRect &area)
     if (cr.isEmpty())
         return;
 
-    int start = posToMapIndex(cr.topLeft());
-    for (int r = 0; r < cr.height(); r++) {
-        for (int c = 0; c < cr.width(); c++) {
-            _map[start + c] = type;
+    if (_regionLoader) {
+        pageIn(cr); // 修改前先加載，修改後的區塊不會被卸下
+    }
+    _map.fill(cr, type);
+    if (_areaIndexEnabled) {
+        invalidateAreaIndex(cr.topLeft());
+    }
+    _version++;
+    markDirty(cr);
+}
+
+// 批量渲染同一類型的多個矩形
+void Board::renderBlocks(MapObjectType type, const QVector<QRect> &areas)
+{
+    QRect          boardRect(QPoint(0, 0), _size);
+    QVector<QRect> changed;
+    changed.reserve(areas.size());
+    foreach (const QRect &area, areas) {
+        QRect cr = boardRect & area;
+        if (!cr.isEmpty()) {
+            changed.append(cr);
+        }
+    }
+    commitBatch(changed, [this, type](int, const QRect &cr) { _map.fill(cr, type); });
+}
+
+// 批量渲染多個行段，每段有自己的類型
+void Board::renderRuns(const QVector<MapRun> &runs)
+{
+    QRect          boardRect(QPoint(0, 0), _size);
+    QVector<QRect> changed;
+    QVector<int>   types; // 與 changed 一一對應
+    changed.reserve(runs.size());
+    types.reserve(runs.size());
+    foreach (const MapRun &run, runs) {
+        QRect cr = boardRect & QRect(run.pos, QSize(run.length, 1));
+        if (!cr.isEmpty()) {
+            changed.append(cr);
+            types.append(run.type);
+        }
+    }
+    commitBatch(changed, [this, &types](int i, const QRect &cr) { _map.fill(cr, MapObjectType(types[i])); });
+}
+
+// 在一個批次中寫入已裁剪的矩形，派生索引只更新一次
+template <typename Writer> void Board::commitBatch(const QVector<QRect> &changed, Writer write)
+{
+    if (changed.isEmpty()) {
+        return;
+    }
+    QPoint from = changed.first().topLeft();
+    _map.beginBatch();
+    for (int i = 0; i < changed.size(); i++) {
+        if (_regionLoader) {
+            pageIn(changed[i]); // 逐個加載後立即寫入，寫入後的區塊不會被之後的加載卸下
+        }
+        write(i, changed[i]);
+        from.setX(qMin(from.x(), changed[i].left()));
+        from.setY(qMin(from.y(), changed[i].top()));
+    }
+    _map.endBatch();
+    if (_areaIndexEnabled) {
+        invalidateAreaIndex(from);
+    }
+    _version++; // 整個批次是一次修改
+    foreach (const QRect &cr, changed) {
+        markDirty(cr);
+    }
+}
+
+// 以當前版本記錄一個變化的矩形
+void Board::markDirty(const QRect &rect)
+{
+    DirtyRect entry = { rect, _version };
+    for (int i = _dirty.size() - 1; i >= qMax(0, _dirty.size() - dirtyMergeDepth); i--) {
+        if (uniteExactly(entry.rect, _dirty.at(i).rect)) { // 合併後移到末尾，保持按版本排序
+            _dirty.remove(i);
+            break;
         }
-        start += _size.width();
+    }
+    _dirty.append(entry);
+    if (_dirty.size() > maxDirtyRects) {
+        int dropped = _dirty.size() - maxDirtyRects * 3 / 4;
+        _dirtyFloor = _dirty.at(dropped - 1).version;
+        _dirty.remove(0, dropped);
+    }
+}
+
+// 收集某版本之後變化的矩形
+bool Board::dirtyRegions(quint64 since, QVector<QRect> &regions) const
+{
+    if (since < _dirtyFloor) {
+        return false;
+    }
+    for (int i = _dirty.size() - 1; i >= 0 && _dirty.at(i).version > since; i--) {
+        regions.append(_dirty.at(i).rect);
+    }
+    return true;
+}
+
+// 收集某版本之後變化的矩形並清空記錄
+bool Board::takeDirtyRegions(quint64 since, QVector<QRect> &regions)
+{
+    bool complete = dirtyRegions(since, regions);
+    discardDirtyRegions(_version);
+    return complete;
+}
+
+// 登記坦克佔據的格子
+void Board::addOccupant(const DynamicBlock *tank)
+{
+    QRect g = tank->geometry();
+    for (int y = g.top(); y <= g.bottom(); y++) {
+        for (int x = g.left(); x <= g.right(); x++) {
+            _occupancy.insert(cellKey(x, y), tank);
+        }
+    }
+}
+
+// 坦克移動後更新佔據的格子
+void Board::moveOccupant(const DynamicBlock *tank, const QRect &from)
+{
+    releaseCells(from, tank);
+    addOccupant(tank);
+}
+
+// 移除坦克佔據的格子
+void Board::removeOccupant(const DynamicBlock *tank) { releaseCells(tank->geometry(), tank); }
+
+// 釋放矩形內屬於該坦克的格子
+void Board::releaseCells(const QRect &rect, const DynamicBlock *tank)
+{
+    for (int y = rect.top(); y <= rect.bottom(); y++) {
+        for (int x = rect.left(); x <= rect.right(); x++) {
+            auto it = _occupancy.find(cellKey(x, y));
+            if (it != _occupancy.end() && it.value() == tank) {
+                _occupancy.erase(it);
+            }
+        }
+    }
+}
+
+// 查找矩形內除 except 外的坦克
+const DynamicBlock *Board::occupant(const QRect &rect, const DynamicBlock *except) const
+{
+    if (_occupancy.isEmpty()) {
+        return nullptr;
+    }
+    for (int y = rect.top(); y <= rect.bottom(); y++) {
+        for (int x = rect.left(); x <= rect.right(); x++) {
+            const DynamicBlock *b = _occupancy.value(cellKey(x, y));
+            if (b && b != except) {
+                return b;
+            }
+        }
+    }
+    return nullptr;
+}
+
+// 獲取地形快照的函數
+Board::Snapshot Board::snapshot() const
+{
+    Snapshot s;
+    s._map     = _map;
+    s._version = _version;
+    s._mapId   = _mapId;
+    return s;
+}
+
+// 恢復地形快照的函數
+bool Board::restore(const Snapshot &snapshot)
+{
+    if (snapshot._mapId != _mapId || snapshot.isNull()) {
+        return false;
+    }
+    QVector<QRect> changed;
+    _map.changedChunks(snapshot._map, changed);
+    _map = snapshot._map;
+    if (changed.isEmpty()) {
+        return true;
+    }
+    _version++;
+    foreach (const QRect &r, changed) {
+        if (_areaIndexEnabled) {
+            invalidateAreaIndex(r.topLeft());
+        }
+        markDirty(r);
+    }
+    return true;
+}
+
+// 丟棄不晚於某版本的記錄
+void Board::discardDirtyRegions(quint64 upTo)
+{
+    int n = 0;
+    while (n < _dirty.size() && _dirty.at(n).version <= upTo) {
+        n++;
+    }
+    if (n) {
+        _dirtyFloor = qMax(_dirtyFloor, _dirty.at(n - 1).version);
+        _dirty.remove(0, n);
     }
 }
 
@@ -115,12 +384,188 @@ Board::BlockProps Board::rectProps(const QRect &rect)
     if (!QRect(QPoint(0, 0), _size).contains(rect)) {
         return TankObstackle;
     }
-    for (int i = 0; i < rect.width(); i++) {
-        for (int j = 0; j < rect.height(); j++) {
-            props |= blockProperties(QPoint(rect.x() + i, rect.y() + j));
+    if (_regionLoader) {
+        pageIn(rect);
+    }
+    if (_areaIndexEnabled && rect.width() * rect.height() >= areaIndexMinCells) {
+        for (int p = 0; p < planesCount; p++) {
+            if (areaSum(p, rect)) {
+                props |= planeProps[p];
+            }
+        }
+        return props;
+    }
+    // 各區塊逐行把字 OR 起來，最後再套用列遮罩。坦克和子彈的矩形通常落在一個區塊內
+    quint8 planes = _map.rectPlanes(rect);
+    for (int p = 0; p < planesCount; p++) {
+        if (planes & (1 << p)) {
+            props |= planeProps[p];
         }
     }
     return props;
 }
 
+// 開啟或關閉面積和表索引的函數
+void Board::setAreaIndexEnabled(bool enabled)
+{
+    if (enabled == _areaIndexEnabled) {
+        return;
+    }
+    if (enabled && _regionLoader) {
+        return; // 分頁棋盤的面積和表大小與整張地圖成正比
+    }
+    _areaIndexEnabled = enabled;
+    if (enabled) {
+        _areaIndex.resize(planesCount * (_size.width() + 1) * (_size.height() + 1));
+        invalidateAreaIndex(QPoint(0, 0));
+    } else {
+        _areaIndex = QVector<int>();
+    }
+}
+
+// 標記從 from 格開始往右下的表項過期，下次查詢時才重算
+void Board::invalidateAreaIndex(const QPoint &from)
+{
+    if (_areaDirty.x() > from.x()) {
+        _areaDirty.setX(from.x());
+    }
+    if (_areaDirty.y() > from.y()) {
+        _areaDirty.setY(from.y());
+    }
+}
+
+// 用面積和表計算矩形內某個位平面的置位格子數
+int Board::areaSum(int plane, const QRect &rect) const
+{
+    int  stride = _size.width() + 1;
+    int *table  = _areaIndex.data() + plane * stride * (_size.height() + 1);
+
+    // 用到的最右下表項是 (right + 1, bottom + 1)，它未過期則其餘三個也未過期
+    int dx = _areaDirty.x(), dy = _areaDirty.y();
+    if (rect.right() + 1 > dx && rect.bottom() + 1 > dy) {
+        for (int p = 0; p < planesCount; p++) {
+            int *t = _areaIndex.data() + p * stride * (_size.height() + 1);
+            for (int y = dy; y < _size.height(); y++) {
+                int    *cur  = t + (y + 1) * stride;
+                int    *up   = t + y * stride;
+                quint64 bits = _map.planeWord(p, dx, y);
+                for (int x = dx; x < _size.width(); x++) {
+                    if (!(x & ChunkedMap::ChunkMask)) {
+                        bits = _map.planeWord(p, x, y);
+                    }
+                    int cell   = (bits >> (x & ChunkedMap::ChunkMask)) & 1;
+                    cur[x + 1] = cell + up[x + 1] + cur[x] - up[x];
+                }
+            }
+        }
+        _areaDirty = QPoint(_size.width(), _size.height());
+    }
+
+    int l = rect.left(), t = rect.top(), r = rect.right() + 1, b = rect.bottom() + 1;
+    return table[b * stride + r] - table[t * stride + r] - table[b * stride + l] + table[t * stride + l];
+}
+
+// 計算區域內具有某個屬性的格子數
+int Board::propCount(BlockProp prop, const QRect &rect) const
+{
+    QRect cr = QRect(QPoint(0, 0), _size) & rect;
+    int   p  = 0;
+    while (p < planesCount && planeProps[p] != prop) {
+        p++;
+    }
+    if (p == planesCount || cr.isEmpty()) {
+        return 0;
+    }
+    if (_areaIndexEnabled) {
+        return areaSum(p, cr);
+    }
+    if (_regionLoader) {
+        pageIn(cr);
+    }
+    return _map.countPlane(p, cr);
+}
+
+// 設置內存預算的函數
+void Board::setMemoryBudget(qint64 bytes)
+{
+    qint64 oneChunk = ChunkedMap::worstCaseBytes(QSize(ChunkedMap::ChunkSize, ChunkedMap::ChunkSize));
+    _memoryBudget   = qMax(oneChunk, bytes);
+}
+
+// 加載器即將被銷毀，之後不再分頁
+void Board::detachLoader() { _regionLoader = nullptr; }
+
+// 加載區域內缺失的區塊，必要時卸下舊區塊
+void Board::pageIn(const QRect &area) const
+{
+    QRect cr = area & QRect(QPoint(0, 0), _size);
+    if (cr.isEmpty()) {
+        return;
+    }
+    bool loaded = false;
+    for (int cy = cr.top() >> ChunkedMap::ChunkShift; cy <= cr.bottom() >> ChunkedMap::ChunkShift; cy++) {
+        for (int cx = cr.left() >> ChunkedMap::ChunkShift; cx <= cr.right() >> ChunkedMap::ChunkShift; cx++) {
+            if (_map.chunkState(cx, cy) == ChunkedMap::Missing) {
+                if (!loaded) {
+                    _pageClock++;
+                    loaded = true;
+                }
+                loadChunk(cx, cy);
+            }
+            _map.touch(cx, cy, _pageClock);
+        }
+    }
+    if (loaded && _map.storageBytes() > _memoryBudget) {
+        _map.evictClean(_memoryBudget * 3 / 4, _pageClock);
+    }
+}
+
+// RunIterator 類的構造函數，矩形被裁剪到棋盤內
+Board::RunIterator::RunIterator(const Board &board, const QRect &rect) :
+    _board(&board), _rect(rect & QRect(QPoint(0, 0), board._size))
+{
+    _run.pos    = _rect.topLeft();
+    _run.length = 0;
+    _run.type   = Nothing;
+    if (isValid()) {
+        readRun();
+    }
+}
+
+// 移動到下一段
+Board::RunIterator &Board::RunIterator::operator++()
+{
+    _run.pos.rx() += _run.length;
+    if (_run.pos.x() > _rect.right()) {
+        _run.pos = QPoint(_rect.left(), _run.pos.y() + 1);
+    }
+    if (isValid()) {
+        readRun();
+    }
+    return *this;
+}
+
+// 讀取從當前位置開始的一段
+void Board::RunIterator::readRun()
+{
+    if (_board->_regionLoader && _run.pos.x() == _rect.left()) { // 分頁模式下逐行加載
+        _board->pageIn(QRect(_rect.left(), _run.pos.y(), _rect.width(), 1));
+    }
+    _run.length = _board->_map.runLength(_run.pos.x(), _run.pos.y(), _rect.right(), _run.type);
+}
+
+// 從加載器加載一個區塊
+void Board::loadChunk(int cx, int cy) const
+{
+    QRect rect = _map.chunkRect(cx, cy);
+    QRect region(rect.topLeft() / MAP_SCALE_FACTOR, rect.bottomRight() / MAP_SCALE_FACTOR);
+    _map.beginBatch();
+    foreach (const MapObject &block, _regionLoader->loadRegion(region)) {
+        QRect cropped(block.geometry.topLeft() * MAP_SCALE_FACTOR, block.geometry.size() * MAP_SCALE_FACTOR);
+        _map.fill(cropped & rect, block.type);
+    }
+    _map.endBatch();
+    _map.setChunkState(cx, cy, ChunkedMap::Clean);
+}
+
 } // namespace Tanks
@@ -2,8 +2,10 @@
 #define TANKS_BOARD_H
 
 #include "abstractmaploader.h"
+#include "chunkedmap.h"
 #include "dynamicblock.h"
 
+#include <QHash>
 #include <QObject>
 #include <QSize>
 #include <QVector>
@@ -34,46 +36,135 @@ public:
      * Iterates over all blocks line by line
      */
     class Iterator {
-        const QVector<MapItem> _map; // copy-on-write and we are protected from board deletion;
-        QPoint                 _pos;
-        int                    _width;
-        int                    _index;
+        const ChunkedMap _map; // copy-on-write and we are protected from board deletion;
+        QPoint           _pos;
+        int              _width;
+        int              _height;
 
     public:
-        Iterator(const Board &board) : _map(board._map), _width(board._size.width()), _index(0) { }
+        Iterator(const Board &board) :
+            _map(board._map), _width(board._size.width()), _height(_width ? board._size.height() : 0)
+        {
+        }
 
-        inline bool      isValid() const { return _index < _map.size(); }
+        inline bool      isValid() const { return _pos.y() < _height; }
         inline Iterator &operator++()
         {
-            _index++;
             if (++_pos.rx() >= _width) {
                 _pos.setX(0);
                 _pos.ry()++;
             }
             return *this;
         }
-        inline MapItem      operator*() const { return isValid() ? _map.value(_index) : 0; }
+        inline MapItem      operator*() const { return _map.at(_pos.x(), _pos.y()); }
         inline const QPoint pos() const { return _pos; }
     };
     friend class Iterator;
     inline Iterator iterate() const { return Iterator(*this); }
 
+    struct MapRun {
+        QPoint        pos; // 第一個格子
+        int           length;
+        MapObjectType type;
+    };
+
+    /**
+     * @brief The RunIterator class
+     * Iterates over runs of same-type blocks inside a rect, row by row.
+     * Reads the board in place: the board must outlive the iterator and
+     * must not be modified while iterating.
+     */
+    class RunIterator {
+        const Board *_board;
+        QRect        _rect;
+        MapRun       _run;
+
+        void readRun();
+
+    public:
+        RunIterator(const Board &board, const QRect &rect);
+
+        inline bool          isValid() const { return _run.pos.y() <= _rect.bottom(); }
+        RunIterator         &operator++();
+        inline const MapRun &operator*() const { return _run; }
+        inline const MapRun *operator->() const { return &_run; }
+    };
+    friend class RunIterator;
+    inline RunIterator runs() const { return RunIterator(*this, QRect(QPoint(0, 0), _size)); }
+    inline RunIterator runs(const QRect &rect) const { return RunIterator(*this, rect); } // 單行即 QRect(0, y, w, 1)
+
+    /**
+     * @brief The Snapshot class
+     * Terrain of the board at some version. Chunks are shared with the board
+     * and copied only when renderBlock later modifies them, so taking a
+     * snapshot costs about as much as copying an implicitly shared vector.
+     */
+    class Snapshot {
+        friend class Board;
+        ChunkedMap _map;
+        quint64    _version;
+        quint32    _mapId; // 快照只能恢復到同一張地圖
+
+    public:
+        Snapshot() : _version(0), _mapId(0) { }
+        inline bool    isNull() const { return _mapId == 0; }
+        inline quint64 version() const { return _version; }
+    };
+
     explicit Board(QObject *parent = 0);
     bool loadMap(AbstractMapLoader *loader);
 
-    inline int posToMapIndex(const QPoint &pos) const { return pos.y() * _size.width() + pos.x(); }
-
-    inline MapObjectType blockType(const QPoint &pos) const { return (MapObjectType)_map.value(posToMapIndex(pos)); }
+    inline MapObjectType blockType(const QPoint &pos) const
+    {
+        if (_regionLoader) {
+            pageIn(QRect(pos, QSize(1, 1)));
+        }
+        return _map.at(pos.x(), pos.y());
+    }
 
     inline BlockProps blockProperties(const QPoint &pos) const { return blockTypeProperties(blockType(pos)); }
 
     BlockProps blockTypeProperties(MapObjectType type) const;
     BlockProps rectProps(const QRect &rect);
 
+    // 可選的面積和表索引：任意大小矩形的查詢均為 O(1)，每個屬性每格多佔 4 字節
+    void        setAreaIndexEnabled(bool enabled);
+    inline bool isAreaIndexEnabled() const { return _areaIndexEnabled; }
+    int         propCount(BlockProp prop, const QRect &rect) const; // 區域內具有該屬性的格子數
+
     void renderBlock(MapObjectType type, const QRect &area);
+    // 批量寫入：存儲按行填充，面積和表、版本和髒區域每批只更新一次
+    void renderBlocks(MapObjectType type, const QVector<QRect> &areas);
+    void renderRuns(const QVector<MapRun> &runs); // 按順序寫入，後面的段覆蓋前面的
 
     inline const QSize &size() const { return _size; }
     int                 blockDivider() const;
+    inline qint64       storageBytes() const { return _map.storageBytes(); }
+
+    // 內存預算。加載器支持按區域加載時棋盤以分頁模式運行：區塊在首次使用時加載，
+    // 超出預算時卸下最久未使用且未被修改的區塊。否則整張地圖按預算縮小後一次加載
+    void          setMemoryBudget(qint64 bytes);
+    inline qint64 memoryBudget() const { return _memoryBudget; }
+    inline bool   isPaged() const { return _regionLoader != nullptr; }
+    void          ensureResident(const QRect &area) const { pageIn(area); }
+    void          detachLoader(); // 加載器即將被銷毀
+
+    // 地形版本與髒區域記錄。每次 renderBlock 版本加一；消費者記住上次處理的版本，
+    // 之後只取出此後變化的矩形。記錄被丟棄時返回 false，消費者需要整體刷新
+    inline quint64 version() const { return _version; }
+    bool           dirtyRegions(quint64 since, QVector<QRect> &regions) const;
+    bool           takeDirtyRegions(quint64 since, QVector<QRect> &regions); // 取出後清空，僅適用於單一消費者
+    void           discardDirtyRegions(quint64 upTo);
+
+    // 地形快照，用於 AI 預測、回滾和存檔點。恢復時變化的區塊記為髒區域，版本繼續遞增
+    Snapshot snapshot() const;
+    bool     restore(const Snapshot &snapshot); // 快照來自其他地圖時返回 false
+
+    // 坦克佔用層：記錄每個格子被哪輛坦克佔據，只存儲被佔據的格子，每格查詢 O(1)
+    void                addOccupant(const DynamicBlock *tank);
+    void                moveOccupant(const DynamicBlock *tank, const QRect &from); // from 為移動前的位置
+    void                removeOccupant(const DynamicBlock *tank);
+    const DynamicBlock *occupant(const QRect &rect, const DynamicBlock *except = nullptr) const; // 矩形內其他坦克
 
     // bool addDynBlock(QSharedPointer<DynamicBlock> dblock);
     void clockTick();
@@ -91,13 +182,40 @@ signals:
 
 public slots:
 private:
-    QSize            _size;
-    QVector<MapItem> _map;
+    void invalidateAreaIndex(const QPoint &from);
+    int  areaSum(int plane, const QRect &rect) const;
+    void pageIn(const QRect &area) const;
+    void loadChunk(int cx, int cy) const;
+    void markDirty(const QRect &rect);
+    void releaseCells(const QRect &rect, const DynamicBlock *tank);
+    static inline quint64 cellKey(int x, int y) { return (quint64(quint32(y)) << 32) | quint32(x); }
+    template <typename Writer> void commitBatch(const QVector<QRect> &changed, Writer write);
+
+    struct DirtyRect {
+        QRect   rect;
+        quint64 version; // 最後一次修改的版本
+    };
+
+    QSize              _size;
+    mutable ChunkedMap _map; // 分塊存儲，每格 4 位，並帶有各屬性的位平面。分頁模式下查詢時按需加載
+    AbstractMapLoader *_regionLoader; // 分頁模式的加載器，不擁有
+    qint64             _memoryBudget;
+    mutable quint32    _pageClock; // 每加載一個區塊加一，用於 LRU
+
+    quint64            _version;
+    QVector<DirtyRect> _dirty; // 按版本排序，只合併並集恰為矩形的記錄
+    quint64            _dirtyFloor; // 不晚於此版本的記錄已被丟棄
+    quint32            _mapId; // 每次加載地圖加一
+
+    bool                 _areaIndexEnabled;
+    mutable QVector<int> _areaIndex; // 每個位平面的面積和表，(w + 1) x (h + 1)
+    mutable QPoint       _areaDirty; // 表中 x > dirty.x 且 y > dirty.y 的部分已過期
     // std::list<QSharedPointer<DynamicBlock>> _dynBlocks;
-    QList<quint8> _initialEnemyTanks;
-    QList<QPoint> _enemyStartPositions;
-    QList<QPoint> _friendlyStartPositions;
-    QPoint        _flagPosition;
+    QHash<quint64, const DynamicBlock *> _occupancy; // 被坦克佔據的格子
+    QList<quint8>                        _initialEnemyTanks;
+    QList<QPoint>                        _enemyStartPositions;
+    QList<QPoint>                        _friendlyStartPositions;
+    QPoint                               _flagPosition;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(Board::BlockProps)
@@ -25,36 +25,40 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+
 #ifndef TANKS_BULLET_H
 #define TANKS_BULLET_H
 
-#include "dynamicblock.h"
+#include "basics.h"
+
+#include <QRect>
 
 namespace Tanks {
 
-class Bullet : public DynamicBlock {
-    Q_OBJECT
-public:
+/**
+ * @brief The Bullet struct
+ * Description of a shot as the tank fires it. Live bullets are not objects
+ * of their own: Game copies the shot into its BulletPool and refers to it
+ * by handle from then on.
+ */
+struct Bullet {
     enum Level { Regular, ArmorPiercing };
 
     enum ExplosionType { NoDamage, BrickDestroyed, Explosion, BigExplosion };
 
-    Bullet(Affinity affinity, Level level);
-
-    inline Affinity      affinity() const { return _affinity; }
-    inline Level         level() const { return _level; }
-    void                 explode(ExplosionType);
-    inline ExplosionType explosionType() const { return _etype; }
-
-    OutBoardAction outBoardAction() const;
+    inline Bullet(Affinity affinity = Friendly, Level level = Regular) :
+        affinity(affinity), level(level), speed(2), direction(North)
+    {
+    }
 
-signals:
-    void detonated();
+    static inline QSize size() { return QSize(2, 2); } // 棋盤座標中為 2x2
+    inline QRect        geometry() const { return QRect(position, size()); }
 
-private:
-    Affinity      _affinity;
-    Level         _level;
-    ExplosionType _etype;
+    Affinity  affinity;
+    Level     level;
+    quint8    speed; // 與 DynamicBlock 相同，0 最快
+    Direction direction;
+    QPoint    position; // 左上角
 };
 
 } // namespace Tanks
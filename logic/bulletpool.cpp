@@ -0,0 +1,195 @@
+#include "bulletpool.h"
+
+namespace Tanks {
+
+// BulletPool 類的構造函數
+BulletPool::BulletPool() : _deadCount(0) { }
+
+// 放入一顆新子彈，返回它的句柄
+BulletPool::Handle BulletPool::spawn(const Bullet &bullet)
+{
+    Handle handle = _handles.insert(_handle.size());
+
+    int dx = 0, dy = 0;
+    switch (bullet.direction) {
+    case North:
+        dy = -1;
+        break;
+    case South:
+        dy = 1;
+        break;
+    case West:
+        dx = -1;
+        break;
+    case East:
+        dx = 1;
+        break;
+    }
+    _x.append(bullet.position.x());
+    _y.append(bullet.position.y());
+    _dx.append(dx);
+    _dy.append(dy);
+    _speed.append(qMin<int>(bullet.speed, 3));
+    _phase.append(0);
+    _moves.append(0);
+    _affinity.append(bullet.affinity);
+    _level.append(bullet.level);
+    _direction.append(bullet.direction);
+    _dead.append(0);
+    _spatialSlot.append(-1);
+    _handle.append(handle);
+    return handle;
+}
+
+// 清空所有子彈，已發出的句柄全部失效
+void BulletPool::clear()
+{
+    for (int i = 0; i < _handle.size(); i++) {
+        _handles.remove(_handle.at(i));
+    }
+    _x.resize(0);
+    _y.resize(0);
+    _dx.resize(0);
+    _dy.resize(0);
+    _speed.resize(0);
+    _phase.resize(0);
+    _moves.resize(0);
+    _affinity.resize(0);
+    _level.resize(0);
+    _direction.resize(0);
+    _dead.resize(0);
+    _spatialSlot.resize(0);
+    _handle.resize(0);
+    _deadCount = 0;
+}
+
+// 推進 n 顆子彈的時鐘和位置。與 DynamicBlock 的 move() 加 clockTick() 節奏相同，
+// 但不含分支，陣列互不重疊，編譯器可把整個循環向量化
+static int advanceBullets(int n, int substeps, qint32 *__restrict x, qint32 *__restrict y, qint32 *__restrict phase,
+                          qint32 *__restrict moves, const qint32 *__restrict dx, const qint32 *__restrict dy,
+                          const qint32 *__restrict speed)
+{
+    int moved = 0;
+    for (int i = 0; i < n; i++) {
+        qint32 p = phase[i];
+        qint32 m = 0;
+        for (int s = 0; s < substeps; s++) {
+            qint32 go = p == 0;
+            m += go;
+            p += go * (speed[i] - p); // 移動後重設為 speed
+            p -= p > 0;
+        }
+        phase[i] = p;
+        moves[i] = m;
+        x[i] += dx[i] * m;
+        y[i] += dy[i] * m;
+        moved += m > 0;
+    }
+    return moved;
+}
+
+// 推進所有子彈的時鐘並移到本週期的終點
+int BulletPool::advance()
+{
+    return advanceBullets(_handle.size(), ClockSubsteps, _x.data(), _y.data(), _phase.data(), _moves.data(),
+                          _dx.constData(), _dy.constData(), _speed.constData());
+}
+
+// 本週期起點和終點之間經過的範圍
+QRect BulletPool::sweptRect(int i) const
+{
+    int    m = _moves.at(i);
+    QPoint start(_x.at(i) - _dx.at(i) * m, _y.at(i) - _dy.at(i) * m);
+    return geometry(i) | QRect(start, Bullet::size());
+}
+
+// 獲取子彈前方移動區域
+QRect BulletPool::forwardMoveRect(int i, int distance) const
+{
+    QRect g = geometry(i);
+    switch (_direction.at(i)) {
+    case North:
+        return QRect(g.left(), g.top() - distance, g.width(), distance);
+    case South:
+        return QRect(g.left(), g.y() + g.height(), g.width(), distance);
+    case West:
+        return QRect(g.left() - distance, g.top(), distance, g.height());
+    case East:
+        return QRect(g.x() + g.width(), g.top(), distance, g.height());
+    }
+    return QRect();
+}
+
+// 回到本週期起點
+void BulletPool::rewind(int i)
+{
+    _x[i] -= _dx.at(i) * _moves.at(i);
+    _y[i] -= _dy.at(i) * _moves.at(i);
+}
+
+// 向前移動一格
+void BulletPool::step(int i)
+{
+    _x[i] += _dx.at(i);
+    _y[i] += _dy.at(i);
+}
+
+// 標記子彈已爆炸，compact() 時移除
+void BulletPool::kill(int i)
+{
+    if (!_dead.at(i)) {
+        _dead[i] = 1;
+        _deadCount++;
+    }
+}
+
+// 移除所有已爆炸的子彈
+void BulletPool::compact()
+{
+    for (int i = _handle.size() - 1; _deadCount && i >= 0; i--) {
+        if (_dead.at(i)) {
+            removeAt(i);
+            _deadCount--;
+        }
+    }
+}
+
+// 移除一顆子彈，最後一顆子彈填補它的位置
+void BulletPool::removeAt(int i)
+{
+    _handles.remove(_handle.at(i));
+
+    int last = _handle.size() - 1;
+    if (i != last) {
+        _x[i]           = _x.at(last);
+        _y[i]           = _y.at(last);
+        _dx[i]          = _dx.at(last);
+        _dy[i]          = _dy.at(last);
+        _speed[i]       = _speed.at(last);
+        _phase[i]       = _phase.at(last);
+        _moves[i]       = _moves.at(last);
+        _affinity[i]    = _affinity.at(last);
+        _level[i]       = _level.at(last);
+        _direction[i]   = _direction.at(last);
+        _dead[i]        = _dead.at(last);
+        _spatialSlot[i] = _spatialSlot.at(last);
+        _handle[i]      = _handle.at(last);
+
+        _handles.setIndex(_handle.at(i), i);
+    }
+    _x.removeLast();
+    _y.removeLast();
+    _dx.removeLast();
+    _dy.removeLast();
+    _speed.removeLast();
+    _phase.removeLast();
+    _moves.removeLast();
+    _affinity.removeLast();
+    _level.removeLast();
+    _direction.removeLast();
+    _dead.removeLast();
+    _spatialSlot.removeLast();
+    _handle.removeLast();
+}
+
+} // namespace Tanks
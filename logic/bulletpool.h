@@ -0,0 +1,112 @@
+/*
+ Copyright (c) 2016, Sergey Ilinykh
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL IL'INYKH SERGEY BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef TANKS_BULLETPOOL_H
+#define TANKS_BULLETPOOL_H
+
+#include "bullet.h"
+#include "slotmap.h"
+
+#include <QVector>
+
+namespace Tanks {
+
+/**
+ * @brief The BulletPool class
+ * Live bullets stored as parallel arrays, one entry per bullet, packed
+ * without holes. The clock and position update of all bullets is a single
+ * branch-free loop over these arrays. Entries move when others are removed,
+ * so outside code keeps a Handle, which stays valid until the bullet is
+ * removed and is never reused for another bullet while it matters.
+ */
+class BulletPool {
+public:
+    typedef Tanks::Handle Handle; // 0 is never a valid handle
+
+    // 每週期子彈時鐘推進的步數，與原先每週期兩次 moveBullets() 的速度相同
+    enum { ClockSubsteps = 2 };
+
+    BulletPool();
+
+    Handle spawn(const Bullet &bullet);
+    void   clear();
+
+    inline int    count() const { return _handle.size(); }
+    inline int    indexOf(Handle handle) const { return _handles.indexOf(handle); } // -1 for a removed bullet
+    inline Handle handle(int i) const { return _handle.at(i); }
+
+    // 推進所有子彈的時鐘並把它們移到本週期的終點，返回移動過的子彈數
+    int advance();
+
+    inline int       moves(int i) const { return _moves.at(i); } // 本週期移動的格數
+    inline Affinity  affinity(int i) const { return Affinity(_affinity.at(i)); }
+    inline Direction direction(int i) const { return Direction(_direction.at(i)); }
+    inline Bullet::Level level(int i) const { return Bullet::Level(_level.at(i)); }
+    inline QPoint        position(int i) const { return QPoint(_x.at(i), _y.at(i)); }
+    inline QRect         geometry(int i) const { return QRect(position(i), Bullet::size()); }
+    QRect                sweptRect(int i) const; // 本週期起點到終點經過的範圍
+    QRect                forwardMoveRect(int i, int distance = 1) const;
+
+    void rewind(int i); // 回到本週期起點，由調用者逐格移動
+    void step(int i); // 向前一格
+
+    inline int  spatialSlot(int i) const { return _spatialSlot.at(i); }
+    inline void setSpatialSlot(int i, int slot) { _spatialSlot[i] = slot; }
+
+    // 爆炸的子彈在 compact() 前仍佔據其位置，以便讀取最後的狀態
+    inline bool isDead(int i) const { return _dead.at(i); }
+    void        kill(int i);
+    void        compact();
+
+private:
+    void removeAt(int i);
+
+    // 每週期都讀寫的欄位
+    QVector<qint32> _x;
+    QVector<qint32> _y;
+    QVector<qint32> _dx;
+    QVector<qint32> _dy;
+    QVector<qint32> _speed;
+    QVector<qint32> _phase;
+    QVector<qint32> _moves;
+
+    // 只在碰撞和爆炸時讀取的欄位
+    QVector<quint8> _affinity;
+    QVector<quint8> _level;
+    QVector<quint8> _direction;
+    QVector<quint8> _dead;
+    QVector<int>    _spatialSlot;
+    QVector<Handle> _handle;
+
+    SlotMap _handles;
+    int     _deadCount;
+};
+
+} // namespace Tanks
+
+#endif // TANKS_BULLETPOOL_H
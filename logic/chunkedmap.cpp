@@ -0,0 +1,368 @@
+#include "chunkedmap.h"
+
+#include <QPair>
+#include <QtAlgorithms>
+
+#include <algorithm>
+
+#include <string.h>
+
+namespace Tanks {
+
+// 區塊內一行 [left, right] 列的位遮罩
+static inline quint64 columnsMask(int left, int right)
+{
+    return (~Q_UINT64_C(0) << left) & (~Q_UINT64_C(0) >> (ChunkedMap::ChunkMask - right));
+}
+
+// ChunkedMap 類的構造函數
+ChunkedMap::ChunkedMap() : _chunksX(0), _chunksY(0), _materialized(0), _batchDepth(0)
+{
+    memset(_typePlanes, 0, sizeof(_typePlanes));
+}
+
+// 設置類型與位平面對應關係的函數
+void ChunkedMap::setTypePlanes(const quint8 planes[LastMapObjectType])
+{
+    memcpy(_typePlanes, planes, sizeof(_typePlanes));
+}
+
+// 重設地圖尺寸，所有區塊為 Nothing
+void ChunkedMap::reset(const QSize &size, ChunkState state)
+{
+    _size         = size;
+    _chunksX      = (size.width() + ChunkMask) >> ChunkShift;
+    _chunksY      = (size.height() + ChunkMask) >> ChunkShift;
+    _chunks       = QVector<Chunk>(_chunksX * _chunksY);
+    _materialized = 0;
+    for (auto &chunk : _chunks) {
+        chunk.state = state;
+    }
+}
+
+// 獲取一個格子類型的函數，地圖外為 Nothing
+MapObjectType ChunkedMap::at(int x, int y) const
+{
+    if (uint(x) >= uint(_size.width()) || uint(y) >= uint(_size.height())) {
+        return Nothing;
+    }
+    const Chunk &chunk = chunkAt(x, y);
+    if (!chunk.d) {
+        return MapObjectType(chunk.uniform);
+    }
+    int i = ((y & ChunkMask) << ChunkShift) | (x & ChunkMask);
+    return MapObjectType((chunk.d->cells[i >> 1] >> ((i & 1) << 2)) & 0xf);
+}
+
+// 計算一行中從 (x, y) 開始的同類型格子數
+int ChunkedMap::runLength(int x, int y, int right, MapObjectType &type) const
+{
+    type     = at(x, y);
+    int next = x + 1;
+    while (next <= right) {
+        const Chunk &chunk      = chunkAt(next, y);
+        int          chunkRight = qMin(right, next | ChunkMask);
+        if (!chunk.d) { // 均勻區塊整段跳過
+            if (chunk.uniform != type) {
+                break;
+            }
+            next = chunkRight + 1;
+            continue;
+        }
+        const quint8 *cells = chunk.d->cells + ((y & ChunkMask) << (ChunkShift - 1));
+        const quint8  pair  = quint8(type | (type << 4));
+        while (next <= chunkRight) {
+            int i = next & ChunkMask;
+            if (!(i & 1) && next < chunkRight && cells[i >> 1] == pair) { // 一次比較兩格
+                next += 2;
+                continue;
+            }
+            if (((cells[i >> 1] >> ((i & 1) << 2)) & 0xf) != type) {
+                return next - x;
+            }
+            next++;
+        }
+    }
+    return next - x;
+}
+
+// 用一種類型填充矩形的函數
+void ChunkedMap::fill(const QRect &rect, MapObjectType type)
+{
+    QRect cr = rect & QRect(QPoint(0, 0), _size);
+    if (cr.isEmpty()) {
+        return;
+    }
+    for (int cy = cr.top() >> ChunkShift; cy <= cr.bottom() >> ChunkShift; cy++) {
+        for (int cx = cr.left() >> ChunkShift; cx <= cr.right() >> ChunkShift; cx++) {
+            QRect  whole = chunkRect(cx, cy);
+            QRect  part  = cr & whole;
+            QRect  local = part.translated(-(cx << ChunkShift), -(cy << ChunkShift));
+            Chunk &chunk = _chunks[cy * _chunksX + cx];
+            if (chunk.state == Clean && holds(chunk, local, type)) {
+                continue; // 沒有格子改變，區塊仍可被卸下
+            }
+            chunk.state = Dirty;
+            if (part == whole) { // 整個區塊被覆蓋
+                collapse(chunk, type);
+                continue;
+            }
+            if (!chunk.d) {
+                if (chunk.uniform == type) {
+                    continue;
+                }
+                materialize(chunk);
+            }
+            // 地圖外的格子跟隨邊緣格子，邊緣區塊才能重新變為均勻
+            if (part.right() == _size.width() - 1) {
+                local.setRight(ChunkMask);
+            }
+            if (part.bottom() == _size.height() - 1) {
+                local.setBottom(ChunkMask);
+            }
+            fillChunk(chunk.d.data(), local, type);
+            if (_batchDepth) {
+                if (!chunk.batched) {
+                    chunk.batched = true;
+                    _batchChunks.append(cy * _chunksX + cx);
+                }
+            } else if (isUniform(chunk.d.constData(), type)) {
+                collapse(chunk, type);
+            }
+        }
+    }
+}
+
+// 結束批量寫入，把變為均勻的區塊收縮
+void ChunkedMap::endBatch()
+{
+    if (--_batchDepth) {
+        return;
+    }
+    for (int i : _batchChunks) {
+        Chunk &chunk  = _chunks[i];
+        chunk.batched = false;
+        if (chunk.d) {
+            MapObjectType type = MapObjectType(chunk.d.constData()->cells[0] & 0xf);
+            if (isUniform(chunk.d.constData(), type)) {
+                collapse(chunk, type);
+            }
+        }
+    }
+    _batchChunks.resize(0);
+}
+
+// 計算矩形內出現的位平面
+quint8 ChunkedMap::rectPlanes(const QRect &rect) const
+{
+    const quint8 all = (1 << PlanesCount) - 1;
+    quint8       ret = 0;
+    for (int cy = rect.top() >> ChunkShift; cy <= rect.bottom() >> ChunkShift; cy++) {
+        for (int cx = rect.left() >> ChunkShift; cx <= rect.right() >> ChunkShift; cx++) {
+            const Chunk &chunk = _chunks.at(cy * _chunksX + cx);
+            if (!chunk.d) {
+                ret |= _typePlanes[chunk.uniform];
+            } else {
+                QRect   part = (rect & chunkRect(cx, cy)).translated(-(cx << ChunkShift), -(cy << ChunkShift));
+                quint64 mask = columnsMask(part.left(), part.right());
+                for (int p = 0; p < PlanesCount; p++) {
+                    if (ret & (1 << p)) {
+                        continue;
+                    }
+                    const quint64 *row = chunk.d->planes[p] + part.top();
+                    quint64        acc = 0;
+                    for (int r = 0; r < part.height(); r++) {
+                        acc |= row[r];
+                    }
+                    if (acc & mask) {
+                        ret |= 1 << p;
+                    }
+                }
+            }
+            if (ret == all) {
+                return ret;
+            }
+        }
+    }
+    return ret;
+}
+
+// 計算矩形內某位平面置位的格子數
+int ChunkedMap::countPlane(int plane, const QRect &rect) const
+{
+    int count = 0;
+    for (int cy = rect.top() >> ChunkShift; cy <= rect.bottom() >> ChunkShift; cy++) {
+        for (int cx = rect.left() >> ChunkShift; cx <= rect.right() >> ChunkShift; cx++) {
+            const Chunk &chunk = _chunks.at(cy * _chunksX + cx);
+            QRect        part  = (rect & chunkRect(cx, cy)).translated(-(cx << ChunkShift), -(cy << ChunkShift));
+            if (!chunk.d) {
+                count += (_typePlanes[chunk.uniform] & (1 << plane)) ? part.width() * part.height() : 0;
+                continue;
+            }
+            quint64        mask = columnsMask(part.left(), part.right());
+            const quint64 *row  = chunk.d->planes[plane] + part.top();
+            for (int r = 0; r < part.height(); r++) {
+                count += qPopulationCount(row[r] & mask);
+            }
+        }
+    }
+    return count;
+}
+
+// 獲取包含 (x, y) 的區塊行在某位平面的位
+quint64 ChunkedMap::planeWord(int plane, int x, int y) const
+{
+    const Chunk &chunk = chunkAt(x, y);
+    if (!chunk.d) {
+        return (_typePlanes[chunk.uniform] & (1 << plane)) ? ~Q_UINT64_C(0) : 0;
+    }
+    return chunk.d->planes[plane][y & ChunkMask];
+}
+
+// 收集與另一份拷貝不同的區塊
+void ChunkedMap::changedChunks(const ChunkedMap &other, QVector<QRect> &rects) const
+{
+    if (other._size != _size) {
+        rects.append(QRect(QPoint(0, 0), _size));
+        return;
+    }
+    for (int cy = 0; cy < _chunksY; cy++) {
+        for (int cx = 0; cx < _chunksX; cx++) {
+            const Chunk &a = _chunks.at(cy * _chunksX + cx);
+            const Chunk &b = other._chunks.at(cy * _chunksX + cx);
+            bool paged = (a.state == Missing) != (b.state == Missing); // 未加載的區塊與加載後的內容可能不同
+            if (paged || a.d.constData() != b.d.constData() || (!a.d && a.uniform != b.uniform)) {
+                rects.append(chunkRect(cx, cy));
+            }
+        }
+    }
+}
+
+// 估算存儲佔用的字節數
+qint64 ChunkedMap::storageBytes() const
+{
+    return qint64(_chunks.size()) * sizeof(Chunk) + qint64(_materialized) * sizeof(ChunkData);
+}
+
+// 最壞情況下的存儲字節數
+qint64 ChunkedMap::worstCaseBytes(const QSize &size)
+{
+    qint64 chunks = qint64((size.width() + ChunkMask) >> ChunkShift) * ((size.height() + ChunkMask) >> ChunkShift);
+    return chunks * (sizeof(Chunk) + sizeof(ChunkData));
+}
+
+// 卸下最久未使用的 Clean 區塊
+int ChunkedMap::evictClean(qint64 targetBytes, quint32 keep)
+{
+    QVector<QPair<quint32, int>> candidates; // 使用時間，區塊索引
+    for (int i = 0; i < _chunks.size(); i++) {
+        const Chunk &chunk = _chunks.at(i);
+        if (chunk.d && chunk.state == Clean && chunk.lastUse != keep) {
+            candidates.append(qMakePair(chunk.lastUse, i));
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    int evicted = 0;
+    for (const auto &c : candidates) {
+        if (storageBytes() <= targetBytes) {
+            break;
+        }
+        Chunk &chunk = _chunks[c.second];
+        collapse(chunk, Nothing);
+        chunk.state = Missing;
+        evicted++;
+    }
+    return evicted;
+}
+
+// 獲取區塊在地圖中的矩形（邊緣區塊被裁剪）
+QRect ChunkedMap::chunkRect(int cx, int cy) const
+{
+    return QRect(cx << ChunkShift, cy << ChunkShift, ChunkSize, ChunkSize) & QRect(QPoint(0, 0), _size);
+}
+
+// 把均勻區塊展開為逐格存儲
+void ChunkedMap::materialize(Chunk &chunk)
+{
+    _materialized++;
+    chunk.d = new ChunkData;
+    memset(chunk.d->cells, chunk.uniform | (chunk.uniform << 4), sizeof(chunk.d->cells));
+    for (int p = 0; p < PlanesCount; p++) {
+        memset(chunk.d->planes[p], (_typePlanes[chunk.uniform] & (1 << p)) ? 0xff : 0, sizeof(chunk.d->planes[p]));
+    }
+}
+
+// 把區塊變為單一類型
+void ChunkedMap::collapse(Chunk &chunk, MapObjectType type)
+{
+    if (chunk.d) {
+        _materialized--;
+        chunk.d.reset();
+    }
+    chunk.uniform = type;
+}
+
+// 在區塊內填充矩形，同時更新位平面
+void ChunkedMap::fillChunk(ChunkData *d, const QRect &local, MapObjectType type) const
+{
+    const quint8 pair  = quint8(type | (type << 4));
+    const int    left  = local.left();
+    const int    right = local.right();
+    for (int y = local.top(); y <= local.bottom(); y++) {
+        quint8 *row = d->cells + (y << (ChunkShift - 1));
+        int     x   = left;
+        if (x & 1) { // 行首的奇數格在高 4 位
+            row[x >> 1] = (row[x >> 1] & 0x0f) | quint8(type << 4);
+            x++;
+        }
+        int pairs = (right + 1 - x) >> 1;
+        memset(row + (x >> 1), pair, pairs);
+        x += pairs << 1;
+        if (x <= right) { // 行尾的偶數格在低 4 位
+            row[x >> 1] = (row[x >> 1] & 0xf0) | quint8(type);
+        }
+    }
+
+    quint64 mask = columnsMask(left, right);
+    for (int p = 0; p < PlanesCount; p++) {
+        bool     set = _typePlanes[type] & (1 << p);
+        quint64 *row = d->planes[p];
+        for (int y = local.top(); y <= local.bottom(); y++) {
+            row[y] = set ? row[y] | mask : row[y] & ~mask;
+        }
+    }
+}
+
+// 檢查區塊內的矩形是否已經全部為該類型
+bool ChunkedMap::holds(const Chunk &chunk, const QRect &local, MapObjectType type) const
+{
+    if (!chunk.d) {
+        return chunk.uniform == type;
+    }
+    const ChunkData *d = chunk.d.constData();
+    for (int y = local.top(); y <= local.bottom(); y++) {
+        const quint8 *row = d->cells + (y << (ChunkShift - 1));
+        for (int x = local.left(); x <= local.right(); x++) {
+            if (((row[x >> 1] >> ((x & 1) << 2)) & 0xf) != type) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// 檢查區塊是否全部為同一類型
+bool ChunkedMap::isUniform(const ChunkData *d, MapObjectType type) const
+{
+    const quint64 pattern = Q_UINT64_C(0x0101010101010101) * quint8(type | (type << 4));
+    quint64       diff    = 0;
+    for (size_t i = 0; i < sizeof(d->cells); i += sizeof(quint64)) { // 逐字比較，發佈版本加 -ftree-vectorize 後向量化
+        quint64 word;
+        memcpy(&word, d->cells + i, sizeof(word));
+        diff |= word ^ pattern;
+    }
+    return !diff;
+}
+
+} // namespace Tanks
@@ -0,0 +1,135 @@
+/*
+ Copyright (c) 2016, Sergey Ilinykh
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL IL'INYKH SERGEY BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef TANKS_CHUNKEDMAP_H
+#define TANKS_CHUNKEDMAP_H
+
+#include "basics.h"
+
+#include <QRect>
+#include <QSharedData>
+#include <QSharedDataPointer>
+#include <QVector>
+
+namespace Tanks {
+
+/**
+ * @brief The ChunkedMap class
+ * Cell storage of the Board split into 64x64 chunks. A chunk filled with
+ * a single type keeps just that type. Other chunks pack cells into 4 bits
+ * and keep one 64-bit word per row for each property plane, so the bit-plane
+ * queries of the board stay word-wide. Chunks are implicitly shared and a
+ * copy of the map costs one reference per chunk.
+ *
+ * For paged boards a chunk may be Missing (reads as Nothing) until its owner
+ * loads it. Chunks that were changed after loading are Dirty and are never
+ * evicted since they can't be loaded again.
+ */
+class ChunkedMap {
+public:
+    enum { ChunkShift = 6, ChunkSize = 1 << ChunkShift, ChunkMask = ChunkSize - 1, PlanesCount = 5 };
+    enum ChunkState : quint8 { Missing, Clean, Dirty };
+
+    ChunkedMap();
+
+    // 每種 MapObjectType 所屬的位平面（位遮罩）
+    void setTypePlanes(const quint8 planes[LastMapObjectType]);
+
+    void                reset(const QSize &size, ChunkState state = Dirty);
+    inline const QSize &size() const { return _size; }
+    inline int          chunksX() const { return _chunksX; }
+    inline int          chunksY() const { return _chunksY; }
+
+    MapObjectType at(int x, int y) const;
+    // 從 (x, y) 開始到 right 列為止同一類型的格子數，type 返回該類型。要求 x <= right 且都在地圖內
+    int runLength(int x, int y, int right, MapObjectType &type) const;
+    void          fill(const QRect &rect, MapObjectType type); // 格子有變化的區塊變為 Dirty
+
+    // 批量寫入：期間 fill() 不檢查區塊是否已變為均勻，endBatch() 對每個被修改的區塊只檢查一次。可嵌套
+    void beginBatch() { _batchDepth++; }
+    void endBatch();
+
+    // 以下查詢要求矩形在地圖內
+    quint8 rectPlanes(const QRect &rect) const; // 矩形內出現的位平面
+    int    countPlane(int plane, const QRect &rect) const; // 矩形內該平面置位的格子數
+    // 包含 (x, y) 的區塊行在該平面的位，第 i 位對應列 (x & ~ChunkMask) + i
+    quint64 planeWord(int plane, int x, int y) const;
+
+    int    chunksCount() const { return _chunks.size(); }
+    int    uniformChunksCount() const { return _chunks.size() - _materialized; }
+    qint64 storageBytes() const;
+    // 所有區塊都逐格存儲時的字節數
+    static qint64 worstCaseBytes(const QSize &size);
+
+    // 與另一份拷貝相比存儲不同或加載狀態不同的區塊矩形。共享的區塊視為相同
+    void changedChunks(const ChunkedMap &other, QVector<QRect> &rects) const;
+
+    // 分頁支持
+    inline ChunkState chunkState(int cx, int cy) const { return ChunkState(_chunks.at(cy * _chunksX + cx).state); }
+    inline void       setChunkState(int cx, int cy, ChunkState state) { _chunks[cy * _chunksX + cx].state = state; }
+    inline void       touch(int cx, int cy, quint32 stamp) { _chunks[cy * _chunksX + cx].lastUse = stamp; }
+    QRect             chunkRect(int cx, int cy) const; // 區塊在地圖中的矩形（邊緣區塊被裁剪）
+    // 按最久未使用的順序卸下 Clean 區塊，直到佔用不超過 targetBytes。使用時間為 keep 的區塊保留
+    int evictClean(qint64 targetBytes, quint32 keep);
+
+private:
+    struct ChunkData : public QSharedData {
+        quint64 planes[PlanesCount][ChunkSize]; // 每行一個字
+        quint8  cells[ChunkSize * ChunkSize / 2]; // 每格 4 位
+    };
+    struct Chunk {
+        QSharedDataPointer<ChunkData> d; // 均勻區塊為空
+        quint8                        uniform = Nothing;
+        quint8                        state   = Dirty;
+        quint32                       lastUse = 0;
+        bool                          batched = false; // 已記入 _batchChunks
+    };
+
+    inline const Chunk &chunkAt(int x, int y) const
+    {
+        return _chunks.at((y >> ChunkShift) * _chunksX + (x >> ChunkShift));
+    }
+    void materialize(Chunk &chunk);
+    void collapse(Chunk &chunk, MapObjectType type);
+    void fillChunk(ChunkData *d, const QRect &local, MapObjectType type) const;
+    bool holds(const Chunk &chunk, const QRect &local, MapObjectType type) const;
+    bool isUniform(const ChunkData *d, MapObjectType type) const;
+
+    QSize          _size;
+    int            _chunksX;
+    int            _chunksY;
+    QVector<Chunk> _chunks;
+    int            _materialized; // 逐格存儲的區塊數
+    int            _batchDepth;
+    QVector<int>   _batchChunks; // 本批次中逐格修改過的區塊
+    quint8         _typePlanes[LastMapObjectType];
+};
+
+} // namespace Tanks
+
+#endif // TANKS_CHUNKEDMAP_H
@@ -1,30 +1,39 @@
 #include "dynamicblock.h"
+#include "spatialindex.h"
 
 namespace Tanks {
 
 // DynamicBlock 類的構造函數
-DynamicBlock::DynamicBlock(quint8 speed, Direction direction) : _clockPhase(0), _direction(direction)
+DynamicBlock::DynamicBlock(EntityStore *store, quint8 speed, Direction direction) :
+    _store(store), _entity(store->create()), _spatialIndex(nullptr), _spatialSlot(-1)
 {
+    _store->motion(index()).direction = direction;
     setSpeed(speed); // 設置速度
 }
 
-// 時間流逝的處理函數，控制動態塊的移動能力
-void DynamicBlock::clockTick()
+// DynamicBlock 類的析構函數，實體隨之銷毀
+DynamicBlock::~DynamicBlock()
 {
-    if (_clockPhase) {
-        _clockPhase--; // 時間減少，用於控制移動速度
-    }
+    leaveSpatialIndex();
+    _store->destroy(_entity);
 }
 
-// 檢查動態塊是否可以移動的函數
-bool DynamicBlock::canMove() const { return _clockPhase == 0; }
+// 離開空間索引的函數
+void DynamicBlock::leaveSpatialIndex()
+{
+    if (_spatialIndex) {
+        _spatialIndex->remove(this);
+    }
+}
 
 // 動態塊的移動函數
 void DynamicBlock::move()
 {
-    int distance = 1; // 移動距離
-    int dx = 0, dy = 0;
-    switch (_direction) {
+    int                  i        = index();
+    EntityStore::Motion &motion   = _store->motion(i);
+    int                  distance = 1; // 移動距離
+    int                  dx = 0, dy = 0;
+    switch (motion.direction) {
     case North:
         dy = -distance; // 向北移動
         break;
@@ -38,26 +47,53 @@ void DynamicBlock::move()
         dx = distance; // 向東移動
         break;
     }
-    _geometry.translate(dx, dy); // 更新位置
-    _clockPhase = _speed; // 重設時鐘階段，根據速度
+    _store->geometry(i).translate(dx, dy); // 更新位置
+    motion.clockPhase = motion.speed; // 重設時鐘階段，根據速度
+    if (_spatialIndex) {
+        _spatialIndex->update(this);
+    }
 
-    emit moved(); // 發送移動信號
+    postEvent(GameEvent::TankMoved); // 記錄移動事件
 }
 
 // 獲取動態塊前方移動區域的函數
 QRect DynamicBlock::forwardMoveRect(int distance) const
 {
-    switch (_direction) {
+    int          i = index();
+    const QRect &g = _store->geometry(i);
+    switch (_store->motion(i).direction) {
     case North:
-        return QRect(_geometry.left(), _geometry.top() - distance, _geometry.width(), distance);
+        return QRect(g.left(), g.top() - distance, g.width(), distance);
     case South:
-        return QRect(_geometry.left(), _geometry.y() + _geometry.height(), _geometry.width(), distance);
+        return QRect(g.left(), g.y() + g.height(), g.width(), distance);
     case West:
-        return QRect(_geometry.left() - distance, _geometry.top(), distance, _geometry.height());
+        return QRect(g.left() - distance, g.top(), distance, g.height());
     case East:
-        return QRect(_geometry.x() + _geometry.width(), _geometry.top(), distance, _geometry.height());
+        return QRect(g.x() + g.width(), g.top(), distance, g.height());
     }
     return QRect();
 }
 
+// 生成關於此物件的事件
+GameEvent DynamicBlock::makeEvent(GameEvent::Type type) const
+{
+    int       i = index();
+    GameEvent e = {};
+    e.type      = type;
+    e.subject   = _entity;
+    e.direction = _store->motion(i).direction;
+    e.setRect(_store->geometry(i));
+    return e;
+}
+
+// 把事件寫入實體存儲的事件流
+void DynamicBlock::postEvent(GameEvent::Type type, quint8 detail) const
+{
+    if (GameEventStream *events = _store->eventStream()) {
+        GameEvent e = makeEvent(type);
+        e.detail    = detail;
+        events->write(e);
+    }
+}
+
 } // namespace Tanks
@@ -29,13 +29,25 @@
 #define TANKS_DYNAMICBLOCK_H
 
 #include "basics.h"
-#include "block.h"
+#include "entitystore.h"
+#include "gameevents.h"
 
-#include <QtGlobal>
+#include <QObject>
+#include <QSharedPointer>
 
 namespace Tanks {
 
-class DynamicBlock : public Block {
+class SpatialIndex;
+
+/**
+ * @brief The DynamicBlock class
+ * QObject facade over an entity of an EntityStore. The block owns the
+ * entity for its lifetime but keeps none of its state: geometry and motion
+ * live in the store's component arrays, where the store advances the clock
+ * of all blocks at once. Changes are reported to the store's event stream
+ * rather than through signals.
+ */
+class DynamicBlock : public QObject {
     Q_OBJECT
 public:
     enum ForwardHint { ForwardNothing, ForwardBreakable = 1, ForwardBlock = 2 };
@@ -50,31 +62,43 @@ public:
      * 3 - slowest possible. regular
      */
 
-    DynamicBlock(quint8 speed = 3, Direction direction = North);
-    inline void            setClockPhase(quint16 phase) { _clockPhase = phase; } // useful for freeze bonus
-    virtual void           clockTick();
-    virtual bool           canMove() const;
+    DynamicBlock(EntityStore *store, quint8 speed = 3, Direction direction = North);
+    ~DynamicBlock();
+    inline void            setInitialPosition(const QPoint &p) { _store->geometry(index()).moveTopLeft(p); }
+    inline QRect           geometry() const { return _store->geometry(index()); }
+    // useful for freeze bonus
+    inline void            setClockPhase(quint16 phase) { _store->motion(index()).clockPhase = phase; }
+    inline bool            canMove() const { return _store->motion(index()).clockPhase == 0; }
     void                   move();
     virtual OutBoardAction outBoardAction() const = 0;
     QRect                  forwardMoveRect(int distance = 1) const;
 
     inline void setDirection(Direction dir)
     {
-        _direction = dir;
-        emit moved();
+        _store->motion(index()).direction = dir;
+        postEvent(GameEvent::TankMoved);
     }
-    inline Direction direction() const { return _direction; }
+    inline Direction direction() const { return Direction(_store->motion(index()).direction); }
 
-    inline void setSpeed(quint8 speed) { _speed = speed > 3 ? 3 : speed; }
+    inline void setSpeed(quint8 speed) { _store->motion(index()).speed = speed > 3 ? 3 : speed; }
 
-protected:
-signals:
-    void moved();
+    inline EntityStore::Entity entity() const { return _entity; }
+    virtual GameEvent          makeEvent(GameEvent::Type type) const; // 填好主體、位置和方向的事件
+
+    inline SpatialIndex *spatialIndex() const { return _spatialIndex; }
+    void                 leaveSpatialIndex(); // 爆炸或被摧毀後不再參與碰撞
 
 protected:
-    quint16   _clockPhase;
-    quint8    _speed;
-    Direction _direction;
+    void       postEvent(GameEvent::Type type, quint8 detail = 0) const;
+    inline int index() const { return _store->indexOf(_entity); } // 實體在組件陣列中的當前位置
+
+    EntityStore        *_store;
+    EntityStore::Entity _entity;
+
+private:
+    friend class SpatialIndex;
+    SpatialIndex *_spatialIndex; // 所在的空間索引，由索引維護
+    int           _spatialSlot;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(DynamicBlock::ForwardHints)
@@ -0,0 +1,58 @@
+#include "entitystore.h"
+
+namespace Tanks {
+
+// EntityStore 類的構造函數
+EntityStore::EntityStore() : _events(nullptr) { }
+
+// 創建一個新實體，各組件為預設值
+EntityStore::Entity EntityStore::create()
+{
+    Entity entity = _handles.insert(_entity.size());
+    _geometry.append(QRect());
+    _motion.append(Motion());
+    _armor.append(1);
+    _cooldown.append(0);
+    _entity.append(entity);
+    return entity;
+}
+
+// 銷毀實體，最後一個實體填補它的位置
+void EntityStore::destroy(Entity entity)
+{
+    int i = indexOf(entity);
+    if (i < 0) {
+        return;
+    }
+    _handles.remove(entity);
+
+    int last = _entity.size() - 1;
+    if (i != last) {
+        _geometry[i] = _geometry.at(last);
+        _motion[i]   = _motion.at(last);
+        _armor[i]    = _armor.at(last);
+        _cooldown[i] = _cooldown.at(last);
+        _entity[i]   = _entity.at(last);
+
+        _handles.setIndex(_entity.at(i), i);
+    }
+    _geometry.removeLast();
+    _motion.removeLast();
+    _armor.removeLast();
+    _cooldown.removeLast();
+    _entity.removeLast();
+}
+
+// 時間流逝的處理函數，只觸及移動和武器兩個組件
+void EntityStore::clockTick()
+{
+    const int n        = _entity.size();
+    Motion   *motion   = _motion.data();
+    quint16  *cooldown = _cooldown.data();
+    for (int i = 0; i < n; i++) {
+        motion[i].clockPhase -= motion[i].clockPhase > 0;
+        cooldown[i] -= cooldown[i] > 0;
+    }
+}
+
+} // namespace Tanks
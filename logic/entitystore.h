@@ -0,0 +1,99 @@
+/*
+ Copyright (c) 2016, Sergey Ilinykh
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL IL'INYKH SERGEY BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef TANKS_ENTITYSTORE_H
+#define TANKS_ENTITYSTORE_H
+
+#include "basics.h"
+#include "slotmap.h"
+
+#include <QRect>
+#include <QVector>
+
+namespace Tanks {
+
+class GameEventStream;
+
+/**
+ * @brief The EntityStore class
+ * Simulation state of tanks kept as component arrays, one entry per entity,
+ * packed without holes: geometry, motion (clock phase, speed, direction),
+ * armor and weapon cooldown. Tank objects are thin facades over an entity
+ * and exist for the signals the UI listens to; the per-tick clock of every
+ * entity is one loop over the motion and weapon arrays. Entries move when
+ * others are destroyed, so facades keep an Entity handle and look up the
+ * current index when they need it.
+ */
+class EntityStore {
+public:
+    typedef Handle Entity; // 0 is never a valid entity
+
+    struct Motion {
+        quint16 clockPhase = 0; // 為 0 時可以移動
+        quint8  speed      = 3; // 0 最快，3 最慢
+        quint8  direction  = North;
+    };
+
+    EntityStore();
+
+    Entity create();
+    void   destroy(Entity entity);
+
+    inline int    count() const { return _entity.size(); }
+    inline int    indexOf(Entity entity) const { return _handles.indexOf(entity); } // -1 for a destroyed entity
+    inline Entity entity(int i) const { return _entity.at(i); }
+
+    void clockTick(); // 所有實體的移動時鐘和射擊冷卻各減一
+
+    // 實體的外觀把移動、受損等變化寫入此事件流，可為空
+    inline void             setEventStream(GameEventStream *events) { _events = events; }
+    inline GameEventStream *eventStream() const { return _events; }
+
+    inline QRect        &geometry(int i) { return _geometry[i]; }
+    inline const QRect  &geometry(int i) const { return _geometry.at(i); }
+    inline Motion       &motion(int i) { return _motion[i]; }
+    inline const Motion &motion(int i) const { return _motion.at(i); }
+    inline quint8       &armor(int i) { return _armor[i]; }
+    inline quint8        armor(int i) const { return _armor.at(i); }
+    inline quint16      &cooldown(int i) { return _cooldown[i]; }
+    inline quint16       cooldown(int i) const { return _cooldown.at(i); }
+
+private:
+    QVector<QRect>   _geometry;
+    QVector<Motion>  _motion;
+    QVector<quint8>  _armor;
+    QVector<quint16> _cooldown; // 距離下次可以射擊的週期數
+    QVector<Entity>  _entity;
+
+    SlotMap          _handles;
+    GameEventStream *_events;
+};
+
+} // namespace Tanks
+
+#endif // TANKS_ENTITYSTORE_H
@@ -2,37 +2,166 @@
 #include "ai.h"
 #include "aiplayer.h"
 #include "board.h"
+#include "bulletpool.h"
+#include "entitystore.h"
 #include "flag.h"
+#include "gameevents.h"
 #include "humanplayer.h"
 #include "randommaploader.h"
+#include "randomstreams.h"
+#include "spatialindex.h"
 #include "tank.h"
+#include "tickprofiler.h"
+#include "tickscheduler.h"
 
 #include <QCoreApplication>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
 #include <QTimer>
 
-#include <list>
-
 namespace Tanks {
 
 // GamePrivate 類，用於管理遊戲的內部狀態
 class GamePrivate {
 public:
-    GamePrivate(Game *game) : game(game), board(), mapLoader(nullptr), playersCount(1) { }
+    GamePrivate(Game *game) :
+        game(game), board(), mapLoader(nullptr), playersCount(1), manualClock(false), mapPending(false), ticks(0),
+        batchHead(0), seed(0), nextSeed(QRandomGenerator::global()->generate64()), bulletsFired(0), mapLoadNs(0)
+    {
+        entities.setEventStream(&events);
+    }
 
     Game              *game; // 指向遊戲物件的指針
     Board             *board; // 棋盤物件
     AbstractMapLoader *mapLoader; // 地圖加載器
-    QTimer            *clock; // 遊戲時鐘
+    TickScheduler     *clock; // 遊戲時鐘
     quint8             playersCount; // 玩家數量
     AI                *ai; // AI 物件
+    bool               manualClock; // 由 step() 推進而非 QTimer
+    bool               mapPending; // 地圖已加載但 mapReady 尚未執行
+    quint64            ticks; // 本局已執行的時鐘週期數
+    quint64            batchHead; // 本批週期開始時事件流的位置
+    quint64            seed; // 本局的隨機種子
+    quint64            nextSeed; // 下一局的隨機種子
+    quint64            bulletsFired; // 本局發射的子彈數
+    TickProfiler       profiler; // 週期各階段耗時
+    qint64             mapLoadNs; // 本局 loadMap 的耗時
+    SpatialIndex       spatial; // 場上坦克和子彈的網格索引
+    GameEventStream    events; // 本局的遊戲事件，由前端等消費者按批讀取
+    EntityStore        entities; // 坦克的組件陣列，須在玩家之前聲明以便最後析構
 
     QList<QSharedPointer<HumanPlayer>> humans; // 人類玩家列表
-    std::list<QSharedPointer<Bullet>>  bullets; // 子彈列表
+    BulletPool                         bullets; // 場上的子彈
 
     QSharedPointer<Flag> flag; // 旗幟物件
+
+    bool bulletClash(int index);
+    void explodeBullet(int i, Bullet::ExplosionType type);
+    void postBulletEvent(GameEvent::Type type, int i, quint8 detail);
 };
 
+// 檢查子彈在當前位置的碰撞，有碰撞時子彈爆炸
+bool GamePrivate::bulletClash(int index)
+{
+    QRect                 geom       = bullets.geometry(index);
+    bool                  clashFound = false;
+    Bullet::ExplosionType explType   = Bullet::Explosion;
+    Affinity              invAff     = bullets.affinity(index) == Alien ? Friendly : Alien;
+
+    auto target = static_cast<Tank *>(spatial.find(geom, SpatialIndex::tankLayer(invAff)));
+    if (target) {
+        target->catchBullet();
+        clashFound = true;
+    }
+    if (!clashFound && flag->geometry().intersects(geom)) {
+        clashFound = true;
+        flag->burn();
+        explType = Bullet::BigExplosion;
+        GameEvent e = {};
+        e.type      = GameEvent::FlagLost;
+        e.setRect(flag->geometry());
+        events.write(e);
+        emit game->flagLost();
+        foreach (auto &human, humans) {
+            human->killAll(); // both alive and waiting for a free spawn point
+        }
+    }
+    if (!clashFound) {
+        // meet other bullets
+        int other = spatial.findSlot(geom, SpatialIndex::bulletLayer(invAff));
+        if (other >= 0) {
+            explType = Bullet::BrickDestroyed;
+            // let's imagine tank shoot with bricks / FIXME
+            explodeBullet(bullets.indexOf(spatial.key(other)), explType);
+            clashFound = true;
+        }
+    }
+    if (clashFound) {
+        explodeBullet(index, explType);
+        return true;
+    }
+
+    QRect fmr   = bullets.forwardMoveRect(index);
+    auto  props = board->rectProps(fmr);
+    if (!(props & Board::BulletObstackle)) {
+        return false;
+    }
+
+    // resize damage area to four blocks
+    if (fmr.width() > fmr.height()) {
+        fmr.setWidth(4);
+        fmr.translate(-1, 0);
+    } else {
+        fmr.setHeight(4);
+        fmr.translate(0, -1);
+    }
+    QVector<QRect> damaged;
+    for (int i = 0; i < fmr.width(); i++) {
+        for (int j = 0; j < fmr.height(); j++) {
+            QPoint p(fmr.left() + i, fmr.top() + j);
+            props = board->blockProperties(p);
+            if (props & Board::Breakable) {
+                if (bullets.level(index) == Bullet::ArmorPiercing || !(props & Board::Sturdy)) {
+                    damaged.append(QRect(p, QSize(1, 1)));
+                }
+            }
+        }
+    }
+    bool brickDamage = !damaged.isEmpty();
+    board->renderBlocks(Nothing, damaged); // 一次寫入整個爆炸範圍
+    foreach (const QRect &r, damaged) {
+        GameEvent e = {};
+        e.type      = GameEvent::BlockRemoved;
+        e.setRect(r);
+        events.write(e);
+    }
+    explodeBullet(index, brickDamage ? Bullet::BrickDestroyed : Bullet::NoDamage);
+    return true;
+}
+
+// 子彈爆炸：立即退出碰撞，留在子彈池中直到本週期結束
+void GamePrivate::explodeBullet(int i, Bullet::ExplosionType type)
+{
+    spatial.remove(bullets.spatialSlot(i));
+    bullets.setSpatialSlot(i, -1);
+    bullets.kill(i);
+    postBulletEvent(GameEvent::BulletDetonated, i, type);
+}
+
+// 記錄子彈事件，位置為子彈當前的位置
+void GamePrivate::postBulletEvent(GameEvent::Type type, int i, quint8 detail)
+{
+    GameEvent e = {};
+    e.type      = type;
+    e.subject   = bullets.handle(i);
+    e.affinity  = bullets.affinity(i);
+    e.direction = bullets.direction(i);
+    e.detail    = detail;
+    e.setRect(bullets.geometry(i));
+    events.write(e);
+}
+
 // Game 類的構造函數
 Game::Game(QObject *parent) : QObject(parent), _d(new GamePrivate(this))
 {
@@ -43,9 +172,9 @@ Game::Game(QObject *parent) : QObject(parent), _d(new GamePrivate(this))
     _d->flag      = QSharedPointer<Flag>(new Flag);
 
            // 設置遊戲時鐘
-    _d->clock = new QTimer(this);
-    _d->clock->setInterval(50);
-    connect(_d->clock, &QTimer::timeout, this, &Game::clockTick);
+    _d->clock = new TickScheduler(this);
+    connect(_d->clock, &TickScheduler::tick, this, &Game::clockTick);
+    connect(_d->clock, &TickScheduler::advanced, this, &Game::batchAdvanced);
     connect(_d->ai, &AI::newPlayer, this, &Game::connectPlayerSignals);
 }
 
@@ -61,8 +190,15 @@ Game::~Game()
 void Game::reset()
 {
     _d->clock->stop();
-    _d->humans.clear();
-    _d->bullets.clear();
+    _d->mapPending   = false;
+    _d->ticks        = 0;
+    _d->bulletsFired = 0;
+    _d->events.setTick(0);
+    _d->batchHead = _d->events.head();
+    foreach (auto human, _d->humans) {
+        human->reset(); // 玩家物件在 mapReady() 中重用
+    }
+    _d->bullets.clear(); // 空間索引在下一次 loadMap 後重建
     _d->ai->reset();
     //_d->board->reset();
 }
@@ -70,6 +206,9 @@ void Game::reset()
 // 獲取 Board 物件的函數
 Board *Game::board() const { return _d->board; }
 
+// 獲取 AI 物件的函數
+AI *Game::ai() const { return _d->ai; }
+
 // 設置玩家數量的函數
 void Game::setPlayersCount(int n)
 {
@@ -95,9 +234,104 @@ int Game::playerLifes(int playerId)
     return 0;
 }
 
+// 設置手動時鐘模式的函數（無頭模擬用）
+void Game::setManualClock(bool manual)
+{
+    _d->manualClock = manual;
+    if (manual) {
+        _d->clock->stop();
+    } else if (!_d->mapPending && !_d->humans.isEmpty()) {
+        _d->clock->start();
+    }
+}
+
+// 是否處於手動時鐘模式
+bool Game::isManualClock() const { return _d->manualClock; }
+
+// 連續執行指定數量的時鐘週期，返回實際執行的週期數
+int Game::step(int ticks)
+{
+    if (_d->mapPending) {
+        mapReady(); // 無事件循環時不必等待 singleShot
+    }
+    int done = 0;
+    while (done < ticks && !isFinished()) {
+        clockTick();
+        done++;
+    }
+    return done;
+}
+
+// 獲取本局已執行週期數的函數
+quint64 Game::tickCount() const { return _d->ticks; }
+
+// 檢查本局是否已結束的函數：旗幟被毀、AI 坦克耗盡或所有玩家陣亡
+bool Game::isFinished() const
+{
+    if (_d->mapPending) {
+        return false;
+    }
+    if (_d->flag->isBroken() || !_d->ai->lifesCount()) {
+        return true;
+    }
+    foreach (auto p, _d->humans) {
+        if (p->lifesCount()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 設置下一局隨機種子的函數
+void Game::setSeed(quint64 seed) { _d->nextSeed = seed; }
+
+// 獲取本局隨機種子的函數
+quint64 Game::seed() const { return _d->seed; }
+
+// 更換地圖加載器的函數
+void Game::setMapLoader(AbstractMapLoader *loader)
+{
+    if (loader == _d->mapLoader) {
+        return;
+    }
+    _d->board->detachLoader();
+    delete _d->mapLoader;
+    _d->mapLoader = loader;
+}
+
+// 獲取地圖加載器的函數
+AbstractMapLoader *Game::mapLoader() const { return _d->mapLoader; }
+
+// 獲取本局發射子彈數的函數
+quint64 Game::bulletsFired() const { return _d->bulletsFired; }
+
+// 獲取場上子彈數的函數
+int Game::liveBullets() const { return _d->bullets.count(); }
+
+// 獲取子彈池的函數
+const BulletPool &Game::bullets() const { return _d->bullets; }
+
+// 獲取性能分析器的函數
+TickProfiler *Game::profiler() const { return &_d->profiler; }
+
+// 獲取遊戲時鐘的函數
+TickScheduler *Game::scheduler() const { return _d->clock; }
+
+// 設置時間倍率的函數
+void Game::setTimeScale(double scale) { _d->clock->setTimeScale(scale); }
+
+// 獲取時間倍率的函數
+double Game::timeScale() const { return _d->clock->timeScale(); }
+
 // 獲取旗幟物件的函數
 QSharedPointer<Flag> &Game::flag() const { return _d->flag; }
 
+// 獲取坦克組件存儲的函數
+EntityStore *Game::entities() const { return &_d->entities; }
+
+// 獲取遊戲事件流的函數
+const GameEventStream *Game::events() const { return &_d->events; }
+
 // 連接玩家訊號的函數
 void Game::connectPlayerSignals(AbstractPlayer *player)
 {
@@ -158,29 +392,58 @@ void Game::start(int playersCount)
 {
     reset();
     _d->playersCount = playersCount;
+
+    // 本局使用 nextSeed，並由它確定性地派生下一局的種子
+    _d->seed     = _d->nextSeed;
+    _d->nextSeed = RandomStreams::streamSeed(_d->seed, RandomStreams::NextMatchStream);
+    _d->mapLoader->setRandomSeed(_d->seed);
+    QElapsedTimer loadTimer;
+    loadTimer.start();
     if (!_d->board->loadMap(_d->mapLoader)) {
         qDebug("Failed to load map");
         return;
     }
-    QTimer::singleShot(0, this, &Game::mapReady);
+    _d->mapLoadNs = loadTimer.nsecsElapsed();
+    _d->spatial.reset(_d->board->size());
+    _d->mapPending = true;
+    if (!_d->manualClock) {
+        QTimer::singleShot(0, this, &Game::mapReady); // 手動模式下由 step() 處理
+    }
 }
 
 // 地圖準備就緒的處理函數
 void Game::mapReady()
 {
+    if (!_d->mapPending) {
+        return; // 已由 step() 提前處理
+    }
+    _d->mapPending = false;
     _d->flag->restore();
     _d->flag->setInitialPosition(_d->board->flagPosition());
-    emit mapLoaded();
+    QElapsedTimer loadTimer;
+    loadTimer.start();
+    emit mapLoaded(); // 包含前端的地圖光柵化
+    if (_d->profiler.isEnabled()) {
+        _d->profiler.record(TickProfiler::MapLoadPhase, _d->mapLoadNs + loadTimer.nsecsElapsed());
+    }
 
-    for (int i = 0; i < _d->playersCount; i++) {
+    while (_d->humans.count() > _d->playersCount) {
+        _d->humans.removeLast();
+    }
+    for (int i = _d->humans.count(); i < _d->playersCount; i++) {
         auto human = new HumanPlayer(this, i);
         connectPlayerSignals(human);
         _d->humans.append(QSharedPointer<HumanPlayer>(human));
+    }
+    foreach (auto human, _d->humans) {
         human->start();
     }
 
     _d->ai->start();
-    _d->clock->start();
+    _d->profiler.setBudgetNs(_d->clock->tickIntervalNs());
+    if (!_d->manualClock) {
+        _d->clock->start();
+    }
 
     emit statsChanged();
 }
@@ -190,7 +453,10 @@ void Game::newTankAvailable()
 {
     AbstractPlayer *player = qobject_cast<AbstractPlayer *>(sender());
     auto            tank   = player->tank();
-    emit            newTank(tank.data());
+    GameEvent       e      = tank->makeEvent(GameEvent::TankSpawned);
+    e.detail               = tank->variant();
+    _d->events.write(e);
+    _d->spatial.insert(tank.data(), SpatialIndex::tankLayer(tank->affinity()));
 
     connect(tank.data(), &Tank::fired, this, &Game::onTankFired);
 }
@@ -198,127 +464,98 @@ void Game::newTankAvailable()
 // 坦克射擊的處理函數
 void Game::onTankFired()
 {
-    Tank *tank   = qobject_cast<Tank *>(sender());
-    auto  bullet = tank->takeBullet();
-    _d->bullets.push_front(bullet);
+    Tank *tank = qobject_cast<Tank *>(sender());
+    addBullet(tank->bullet());
+    _d->bulletsFired++;
+}
+
+// 放入子彈的函數
+quint32 Game::addBullet(const Bullet &bullet)
+{
+    BulletPool::Handle  handle = _d->bullets.spawn(bullet);
+    SpatialIndex::Layer layer  = SpatialIndex::bulletLayer(bullet.affinity);
+    int                 i      = _d->bullets.indexOf(handle);
+    _d->bullets.setSpatialSlot(i, _d->spatial.insert(bullet.geometry(), layer, handle));
+    _d->postBulletEvent(GameEvent::BulletFired, i, bullet.level);
+    return handle;
 }
 
 // 時間流逝的處理函數
 void Game::clockTick()
 {
-    foreach (auto p, _d->humans) {
-        p->clockTick();
+    TickProfiler &profiler = _d->profiler;
+    profiler.beginTick();
+    _d->ticks++;
+    _d->events.setTick(quint32(_d->ticks));
+    _d->entities.clockTick(); // 所有坦克的移動時鐘和射擊冷卻，在玩家決策之前
+    {
+        TickProfiler::Scope scope(&profiler, TickProfiler::HumansPhase);
+        foreach (auto p, _d->humans) {
+            p->clockTick();
+        }
     }
-    _d->ai->clockTick();
-
-    for (int bMove = 0; bMove < 2; bMove++) {
+    {
+        TickProfiler::Scope scope(&profiler, TickProfiler::AIPhase);
+        _d->ai->clockTick();
+    }
+    {
+        TickProfiler::Scope scope(&profiler, TickProfiler::BulletsPhase);
         moveBullets();
     }
+    profiler.endTick();
+    if (profiler.isOverrun()) {
+        qWarning("Tick %llu overran %lldms budget: %s",
+                 _d->ticks,
+                 profiler.budgetNs() / 1000000,
+                 qPrintable(profiler.lastTickReport()));
+    }
+
+    // 本批的事件快要寫滿環形緩衝區時提前結束本批，讓讀者在事件被覆蓋前讀取
+    if (_d->events.head() - _d->batchHead >= quint64(_d->events.capacity() / 2)) {
+        _d->clock->endBatch();
+    }
 }
 
-// 子彈移動的函數
+// 一批週期結束，讀者已在 advanced() 中讀取了本批的事件
+void Game::batchAdvanced() { _d->batchHead = _d->events.head(); }
+
+// 子彈移動的函數：先一次推進所有子彈，只有路徑上有物件或障礙的子彈才退回起點逐格檢查，
+// 在第一個障礙處停下
 void Game::moveBullets()
 {
-    auto it = _d->bullets.begin();
-    while (it != _d->bullets.end()) {
-        auto bullet = *it;
-
-        bool                  clashFound = false;
-        Bullet::ExplosionType explType   = Bullet::Explosion;
-        if (bullet->affinity() == Alien) {
-            foreach (auto p, _d->humans) {
-                if (p->tank() && p->tank()->hasClash(*bullet)) {
-                    p->tank()->catchBullet();
-                    clashFound = true;
-                    break;
-                }
-            }
-        } else {
-            QSharedPointer<AIPlayer> p = _d->ai->findClash(bullet.dynamicCast<Block>());
-            if (p) {
-                p->tank()->catchBullet();
-                clashFound = true;
-            }
-        }
-        if (!clashFound && _d->flag->hasClash(*bullet)) {
-            clashFound = true;
-            _d->flag->burn();
-            explType = Bullet::BigExplosion;
-            emit flagLost();
-            foreach (auto &human, _d->humans) {
-                if (human->tank()) { // still alive
-                    human->killAll();
-                }
-            }
+    const QRect boardRect(QPoint(0, 0), _d->board->size());
+    BulletPool &pool = _d->bullets;
+
+    pool.advance();
+    for (int i = 0; i < pool.count(); i++) {
+        // 每個週期都更新，靜止的子彈不能保留上一週期的整段路徑
+        _d->spatial.update(pool.spatialSlot(i), pool.sweptRect(i));
+    }
+
+    for (int i = 0; i < pool.count(); i++) {
+        if (pool.isDead(i)) {
+            continue; // 已被其他子彈擊中
         }
-        if (!clashFound) {
-            // meet other bullets
-            auto it2 = it;
-            ++it2;
-            Affinity invAff = bullet->affinity() == Alien ? Friendly : Alien;
-            while (it2 != _d->bullets.end()) {
-                auto &b2 = **it2;
-                if (b2.affinity() == invAff && b2.hasClash(*bullet)) {
-                    explType = Bullet::BrickDestroyed;
-                    b2.explode(explType); // let's imagine tank shoot with bricks / FIXME
-                    _d->bullets.erase(it2);
-                    clashFound = true;
-                    break;
-                }
-                ++it2;
-            }
+        Affinity invAff = pool.affinity(i) == Alien ? Friendly : Alien;
+        QRect    swept  = pool.sweptRect(i);
+        QRect    ahead  = (swept | pool.forwardMoveRect(i)) & boardRect;
+        bool     clear  = boardRect.contains(pool.geometry(i))
+            && _d->spatial.findSlot(swept, SpatialIndex::tankLayer(invAff) | SpatialIndex::bulletLayer(invAff)) < 0
+            && !_d->flag->geometry().intersects(swept) && !(_d->board->rectProps(ahead) & Board::BulletObstackle);
+        if (clear) {
+            continue;
         }
-        if (clashFound) {
-            it = _d->bullets.erase(it);
-            bullet->explode(explType);
-        } else {
-            QRect fmr = bullet->forwardMoveRect();
-            // qDebug() << "Bullet forward" << fmr;
-            auto props = _d->board->rectProps(fmr);
-            if (props & Board::BulletObstackle) {
-
-                       // resize damage area to four blocks
-                if (fmr.width() > fmr.height()) {
-                    fmr.setWidth(4);
-                    fmr.translate(-1, 0);
-                } else {
-                    fmr.setHeight(4);
-                    fmr.translate(0, -1);
-                }
-                bool brickDamage = false;
-                for (int i = 0; i < fmr.width(); i++) {
-                    for (int j = 0; j < fmr.height(); j++) {
-                        QPoint p(fmr.left() + i, fmr.top() + j);
-                        props = _d->board->blockProperties(p);
-                        if (props & Board::Breakable) {
-                            if (bullet->level() == Bullet::ArmorPiercing || !(props & Board::Sturdy)) {
-                                QRect r(p, QSize(1, 1));
-                                _d->board->renderBlock(Nothing, r);
-                                emit blockRemoved(r);
-                                brickDamage = true;
-                            }
-                        }
-                    }
-                }
-                it = _d->bullets.erase(it);
-                // qDebug("Remove!!!");
-                bullet->explode(brickDamage ? Bullet::BrickDestroyed : Bullet::NoDamage);
-            } else {
-                if (bullet->canMove()) {
-                    bullet->move();
-                    if (!QRect(QPoint(0, 0), _d->board->size()).contains(bullet->geometry())) {
-                        it = _d->bullets.erase(it);
-                        bullet->explode(Bullet::NoDamage);
-                        continue;
-                    }
-                    // emit bulletMoved(bullet.data());
-                }
 
-                bullet->clockTick();
-                ++it;
+        pool.rewind(i);
+        for (int step = 0; !_d->bulletClash(i) && step < pool.moves(i); step++) {
+            pool.step(i);
+            if (!boardRect.contains(pool.geometry(i))) {
+                _d->explodeBullet(i, Bullet::NoDamage);
+                break;
             }
         }
     }
+    pool.compact();
 }
 
 } // namespace Tanks
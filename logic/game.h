@@ -34,9 +34,17 @@
 
 namespace Tanks {
 
+class AbstractMapLoader;
 class AbstractPlayer;
+class AI;
 class Board;
+class BulletPool;
+class EntityStore;
 class Flag;
+class GameEventStream;
+class TickProfiler;
+class TickScheduler;
+struct Bullet;
 
 class GamePrivate;
 class Game : public QObject {
@@ -45,24 +53,59 @@ public:
     explicit Game(QObject *parent = 0);
     ~Game();
     Board                *board() const;
+    AI                   *ai() const;
     QSharedPointer<Flag> &flag() const;
+    EntityStore          *entities() const; // 坦克的模擬狀態，Tank 只是其上的外觀
+
+    // 週期內發生的遊戲事件（坦克、子彈、地形、旗幟），消費者各自保存讀取位置並按批讀取
+    const GameEventStream *events() const;
 
     void setPlayersCount(int n);
     int  playersCount();
     int  aiLifes();
     int  playerLifes(int playerId);
 
+    // 手動時鐘模式：不啟動內部 QTimer，由呼叫者透過 step() 推進遊戲
+    void    setManualClock(bool manual);
+    bool    isManualClock() const;
+    int     step(int ticks = 1);
+    quint64 tickCount() const;
+    bool    isFinished() const;
+
+    // 隨機種子：同一種子重現同一局遊戲。setSeed() 作用於下一次 start()
+    void    setSeed(quint64 seed);
+    quint64 seed() const;
+
+    // 更換地圖加載器，Game 取得其所有權
+    void               setMapLoader(AbstractMapLoader *loader);
+    AbstractMapLoader *mapLoader() const;
+
+    quint64           bulletsFired() const;
+    int               liveBullets() const;
+    const BulletPool &bullets() const; // 場上子彈，子彈事件以其句柄為主體
+
+    // 各階段耗時統計，週期超出時鐘間隔時輸出警告
+    TickProfiler *profiler() const;
+
+    // 固定步長的遊戲時鐘（預設 20 Hz）
+    TickScheduler *scheduler() const;
+
+    // 時間倍率：2、8 倍等每幀執行多個週期，<= 0 表示盡可能快
+    void   setTimeScale(double scale);
+    double timeScale() const;
+
+    // 直接放入一顆子彈（腳本場景與基準測試用），返回它在子彈池中的句柄
+    quint32 addBullet(const Bullet &bullet);
+
 private:
+    friend class GameBenchmark;
     void moveBullets();
     void reset();
 
 signals:
     void mapLoaded();
     void playerRestarted();
-    void newTank(QObject *);
     void tankDestroyed(QObject *);
-    void bulletRemoved(QObject *);
-    void blockRemoved(QRect);
     void flagLost();
     void statsChanged();
 
@@ -77,6 +120,7 @@ private slots:
     void connectPlayerSignals(Tanks::AbstractPlayer *player);
     void mapReady();
     void clockTick();
+    void batchAdvanced();
 
     void newTankAvailable();
     void onTankFired();
@@ -0,0 +1,52 @@
+#include "gameevents.h"
+
+namespace Tanks {
+
+// GameEventStream 類的構造函數，容量為 2 的 capacityLog2 次方
+GameEventStream::GameEventStream(int capacityLog2) :
+    _ring(1 << capacityLog2), _mask((quint64(1) << capacityLog2) - 1), _tick(0), _claimed(0), _published(0)
+{
+}
+
+// 寫入一個事件。先聲明要覆蓋的槽位再寫入，最後發布，讀者因此能識別被覆蓋的舊事件
+void GameEventStream::write(GameEvent event)
+{
+    event.tick = _tick;
+    quint64 n  = _claimed.load(std::memory_order_relaxed);
+    _claimed.store(n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _ring.data()[n & _mask] = event;
+    _published.store(n + 1, std::memory_order_release);
+}
+
+// 讀取事件的函數，可在任意線程調用
+bool GameEventStream::read(quint64 &cursor, QVector<GameEvent> &events) const
+{
+    const quint64 head     = _published.load(std::memory_order_acquire);
+    const quint64 capacity = _mask + 1;
+    bool          complete = true;
+    quint64       from     = qMin(cursor, head);
+    if (head - from > capacity) {
+        from     = head - capacity; // 讀者落後超過一圈
+        complete = false;
+    }
+
+    int first = events.size();
+    events.reserve(first + int(head - from));
+    for (quint64 i = from; i < head; i++) {
+        events.append(_ring.at(int(i & _mask)));
+    }
+
+    // 複製期間寫者可能已開始覆蓋最早的幾個槽位
+    std::atomic_thread_fence(std::memory_order_acquire);
+    quint64 claimed = _claimed.load(std::memory_order_relaxed);
+    if (claimed > capacity && claimed - capacity > from) {
+        quint64 lost = qMin(claimed - capacity, head) - from;
+        events.remove(first, int(lost));
+        complete = false;
+    }
+    cursor = head;
+    return complete;
+}
+
+} // namespace Tanks
@@ -0,0 +1,113 @@
+/*
+ Copyright (c) 2016, Sergey Ilinykh
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL IL'INYKH SERGEY BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef TANKS_GAMEEVENTS_H
+#define TANKS_GAMEEVENTS_H
+
+#include <QRect>
+#include <QVector>
+
+#include <atomic>
+
+namespace Tanks {
+
+/**
+ * @brief The GameEvent struct
+ * One gameplay event as plain data. Tank events carry an EntityStore
+ * entity as subject, bullet events a BulletPool handle. Coordinates are
+ * board coordinates.
+ */
+struct GameEvent {
+    enum Type : quint8 {
+        TankSpawned, // detail: variant
+        TankMoved, // position or direction changed
+        TankArmorChanged, // detail: armor left
+        TankDestroyed,
+        BulletFired, // detail: Bullet::Level
+        BulletDetonated, // detail: Bullet::ExplosionType, at the last position
+        BlockRemoved, // rect of terrain destroyed by a bullet
+        FlagLost
+    };
+
+    quint32 tick;
+    quint32 subject;
+    qint32  x;
+    qint32  y;
+    quint16 width;
+    quint16 height;
+    quint8  type;
+    quint8  affinity;
+    quint8  direction;
+    quint8  detail;
+
+    inline QRect rect() const { return QRect(x, y, width, height); }
+    inline void  setRect(const QRect &r)
+    {
+        x      = r.x();
+        y      = r.y();
+        width  = quint16(r.width());
+        height = quint16(r.height());
+    }
+};
+
+/**
+ * @brief The GameEventStream class
+ * Fixed-size ring of GameEvents with a single writer, the simulation, and
+ * any number of readers. Each reader keeps its own cursor and drains
+ * everything written since, possibly from another thread: writing never
+ * blocks and never waits for readers, so a reader that falls more than a
+ * ring behind loses the oldest events and is told so, as with Board's
+ * dirty regions.
+ */
+class GameEventStream {
+public:
+    explicit GameEventStream(int capacityLog2 = 14);
+
+    inline void setTick(quint32 tick) { _tick = tick; } // 之後寫入的事件屬於該週期
+    void        write(GameEvent event); // 僅限模擬線程
+
+    inline quint64 head() const { return _published.load(std::memory_order_acquire); } // 已寫入的事件總數
+    inline int     capacity() const { return _ring.size(); }
+
+    // 讀取 cursor 之後的事件並把 cursor 移到末尾。中間有事件被覆蓋時返回 false，
+    // events 中只包含仍然完整的部分
+    bool read(quint64 &cursor, QVector<GameEvent> &events) const;
+
+private:
+    QVector<GameEvent>   _ring;
+    quint64              _mask;
+    quint32              _tick;
+    std::atomic<quint64> _claimed; // 開始寫入的事件數，讀者據此判斷哪些槽位可能已被覆蓋
+    std::atomic<quint64> _published; // 寫入完成的事件數
+};
+
+} // namespace Tanks
+
+Q_DECLARE_TYPEINFO(Tanks::GameEvent, Q_PRIMITIVE_TYPE);
+
+#endif // TANKS_GAMEEVENTS_H
@@ -0,0 +1,122 @@
+#include "batchrunner.h"
+#include "board.h"
+#include "flag.h"
+#include "game.h"
+#include "randommaploader.h"
+#include "randomstreams.h"
+#include "tickprofiler.h"
+#include "workstealingpool.h"
+
+#include <QElapsedTimer>
+
+#include <memory>
+#include <vector>
+
+namespace Tanks {
+
+// 累加單局結果
+void BatchStats::add(const MatchResult &r)
+{
+    minTicks = matches ? qMin(minTicks, r.ticks) : r.ticks;
+    maxTicks = qMax(maxTicks, r.ticks);
+    matches++;
+    flagLost += r.flagLost;
+    timedOut += r.timedOut;
+    aiLifes += r.aiLifes;
+    ticks += r.ticks;
+    bulletsFired += r.bulletsFired;
+}
+
+// 合併其他執行緒的統計
+void BatchStats::merge(const BatchStats &other)
+{
+    if (!other.matches) {
+        return;
+    }
+    minTicks = matches ? qMin(minTicks, other.minTicks) : other.minTicks;
+    maxTicks = qMax(maxTicks, other.maxTicks);
+    matches += other.matches;
+    flagLost += other.flagLost;
+    timedOut += other.timedOut;
+    aiLifes += other.aiLifes;
+    ticks += other.ticks;
+    bulletsFired += other.bulletsFired;
+}
+
+BatchRunner::BatchRunner(const Options &options) : _options(options), _elapsedNs(0) { }
+
+// 第 match 局的種子，與執行緒分配無關，因此結果可重現
+quint64 BatchRunner::matchSeed(quint64 batchSeed, int match) { return RandomStreams::streamSeed(batchSeed, match); }
+
+// 設置無頭遊戲及其地圖參數
+void BatchRunner::setupGame(Game &game, const Options &options)
+{
+    auto loader = new RandomMapLoader();
+    loader->setBoardSize(options.boardSize);
+    loader->setEnemyTanksCount(options.enemyTanks);
+    loader->setStreaming(options.streaming);
+    game.setMapLoader(loader);
+    if (options.mapBudget > 0) {
+        game.board()->setMemoryBudget(options.mapBudget);
+    }
+    game.setManualClock(true);
+    game.profiler()->setEnabled(false); // 批量模擬只關心吞吐量
+}
+
+// 進行一局遊戲直到結束或超過最大週期數
+MatchResult BatchRunner::playMatch(Game &game, quint64 seed, int players, int maxTicks)
+{
+    game.setSeed(seed);
+    game.start(players);
+    while (!game.isFinished() && game.tickCount() < quint64(maxTicks)) {
+        if (!game.step(qMin(1024, maxTicks - int(game.tickCount())))) {
+            break;
+        }
+    }
+
+    MatchResult r;
+    r.seed         = seed;
+    r.ticks        = game.tickCount();
+    r.bulletsFired = game.bulletsFired();
+    r.aiLifes      = game.aiLifes();
+    r.flagLost     = game.flag()->isBroken();
+    r.timedOut     = !game.isFinished();
+    return r;
+}
+
+// 在所有核心上執行整批遊戲
+BatchStats BatchRunner::run()
+{
+    WorkStealingPool pool(_options.threads);
+    _results.resize(qMax(0, _options.matches));
+
+    // 每個執行緒一個 Game 與一份統計，避免共享狀態
+    std::vector<std::unique_ptr<Game>> games(pool.threadCount());
+    std::vector<BatchStats>            stats(pool.threadCount());
+
+    MatchResult  *results = _results.data();
+    QElapsedTimer timer;
+    timer.start();
+    pool.run(
+        _results.size(),
+        [&](int worker, int match) {
+            auto &game = games[worker];
+            if (!game) {
+                game.reset(new Game);
+                setupGame(*game, _options);
+            }
+            MatchResult r = playMatch(*game, matchSeed(_options.seed, match), _options.players, _options.maxTicks);
+            results[match] = r;
+            stats[worker].add(r);
+        },
+        [&](int worker) { games[worker].reset(); }); // Game 在建立它的執行緒中銷毀
+    _elapsedNs = timer.nsecsElapsed();
+
+    BatchStats total;
+    for (const auto &s : stats) {
+        total.merge(s);
+    }
+    return total;
+}
+
+} // namespace Tanks
@@ -0,0 +1,99 @@
+/*
+ Copyright (c) 2016, Sergey Ilinykh
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL IL'INYKH SERGEY BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef TANKS_BATCHRUNNER_H
+#define TANKS_BATCHRUNNER_H
+
+#include <QSize>
+#include <QVector>
+
+namespace Tanks {
+
+class Game;
+
+struct MatchResult {
+    quint64 seed         = 0;
+    quint64 ticks        = 0;
+    quint64 bulletsFired = 0;
+    int     aiLifes      = 0;
+    bool    flagLost     = false;
+    bool    timedOut     = false;
+};
+
+struct BatchStats {
+    int     matches      = 0;
+    int     flagLost     = 0;
+    int     timedOut     = 0;
+    qint64  aiLifes      = 0;
+    quint64 ticks        = 0;
+    quint64 minTicks     = 0;
+    quint64 maxTicks     = 0;
+    quint64 bulletsFired = 0;
+
+    void add(const MatchResult &r);
+    void merge(const BatchStats &other);
+};
+
+/**
+ * @brief The BatchRunner class
+ * Plays many independent headless matches across all cores and
+ * aggregates their outcomes. Every worker thread reuses one Game.
+ */
+class BatchRunner {
+public:
+    struct Options {
+        int     matches    = 1;
+        int     threads    = 0; // 0 - all cores
+        int     maxTicks   = 100000;
+        int     players    = 1;
+        quint64 seed       = 0; // seeds of all matches are derived from it
+        QSize   boardSize  = QSize(50, 50); // RandomMapLoader parameters
+        int     enemyTanks = 20;
+        bool    streaming  = false; // generate map regions on demand
+        qint64  mapBudget  = 0;     // board memory budget in bytes, 0 - default
+    };
+
+    explicit BatchRunner(const Options &options);
+
+    BatchStats                         run();
+    inline const QVector<MatchResult> &results() const { return _results; }
+    inline qint64                      elapsedNs() const { return _elapsedNs; }
+
+    static quint64 matchSeed(quint64 batchSeed, int match);
+    static void    setupGame(Game &game, const Options &options);
+    static MatchResult playMatch(Game &game, quint64 seed, int players, int maxTicks);
+
+private:
+    Options              _options;
+    QVector<MatchResult> _results;
+    qint64               _elapsedNs;
+};
+
+} // namespace Tanks
+
+#endif // TANKS_BATCHRUNNER_H
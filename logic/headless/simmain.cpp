@@ -0,0 +1,103 @@
+#include "batchrunner.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QRandomGenerator>
+#include <QTextStream>
+
+// 無頭模擬器：不使用 QML 與 QTimer，直接以 Game::step() 連續推進遊戲，
+// 多局遊戲分散到所有 CPU 核心上執行
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("tankssim");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs Battle City matches without GUI as fast as possible");
+    parser.addHelpOption();
+    QCommandLineOption ticksOption(QStringList() << "t"
+                                                 << "ticks",
+                                   "Maximum ticks per match.",
+                                   "ticks",
+                                   "100000");
+    QCommandLineOption playersOption(QStringList() << "p"
+                                                   << "players",
+                                     "Number of (idle) human players.",
+                                     "players",
+                                     "1");
+    QCommandLineOption matchesOption(QStringList() << "m"
+                                                   << "matches",
+                                     "Number of independent matches to play.",
+                                     "matches",
+                                     "1");
+    QCommandLineOption seedOption(QStringList() << "s"
+                                                << "seed",
+                                  "Batch seed. Seeds of all matches are derived from it.",
+                                  "seed");
+    QCommandLineOption threadsOption(QStringList() << "j"
+                                                   << "threads",
+                                     "Worker threads. 0 uses all cores.",
+                                     "threads",
+                                     "0");
+    QCommandLineOption sizeOption("size", "RandomMapLoader board size in map blocks.", "WxH", "50x50");
+    QCommandLineOption enemiesOption("enemies", "RandomMapLoader enemy tanks per match.", "count", "20");
+    QCommandLineOption streamOption("stream", "Generate map regions on demand and page them under the memory budget.");
+    QCommandLineOption budgetOption("map-budget", "Board memory budget in MiB.", "MiB", "64");
+    QCommandLineOption verboseOption(QStringList() << "v"
+                                                   << "verbose",
+                                     "Print the result of every match.");
+    parser.addOption(ticksOption);
+    parser.addOption(playersOption);
+    parser.addOption(matchesOption);
+    parser.addOption(seedOption);
+    parser.addOption(threadsOption);
+    parser.addOption(sizeOption);
+    parser.addOption(enemiesOption);
+    parser.addOption(streamOption);
+    parser.addOption(budgetOption);
+    parser.addOption(verboseOption);
+    parser.process(app);
+
+    Tanks::BatchRunner::Options options;
+    options.maxTicks   = qMax(1, parser.value(ticksOption).toInt());
+    options.players    = qMax(1, parser.value(playersOption).toInt());
+    options.matches    = qMax(1, parser.value(matchesOption).toInt());
+    options.threads    = qMax(0, parser.value(threadsOption).toInt());
+    options.enemyTanks = qMax(0, parser.value(enemiesOption).toInt());
+    options.streaming  = parser.isSet(streamOption);
+    options.mapBudget  = qMax(1, parser.value(budgetOption).toInt()) * qint64(1024 * 1024);
+    options.seed       = parser.isSet(seedOption) ? parser.value(seedOption).toULongLong()
+                                                  : QRandomGenerator::global()->generate64();
+    QStringList size = parser.value(sizeOption).split('x');
+    if (size.count() == 2) {
+        options.boardSize = QSize(size[0].toInt(), size[1].toInt());
+    }
+
+    Tanks::BatchRunner runner(options);
+    Tanks::BatchStats  stats = runner.run();
+
+    QTextStream out(stdout);
+    if (parser.isSet(verboseOption)) {
+        for (int i = 0; i < runner.results().count(); i++) {
+            const auto &r = runner.results()[i];
+            out << "match " << i << ": seed=" << r.seed << " ticks=" << r.ticks << " flagLost=" << r.flagLost
+                << " aiLifes=" << r.aiLifes << " bullets=" << r.bulletsFired << (r.timedOut ? " (timeout)" : "")
+                << "\n";
+        }
+    }
+
+    double seconds = runner.elapsedNs() / 1e9;
+    int    n       = qMax(1, stats.matches);
+    out << "seed:          " << options.seed << "\n"
+        << "matches:       " << stats.matches << "\n"
+        << "flag lost:     " << stats.flagLost << " (" << 100.0 * stats.flagLost / n << "%)\n"
+        << "timed out:     " << stats.timedOut << "\n"
+        << "AI lives left: " << double(stats.aiLifes) / n << " avg\n"
+        << "ticks:         " << double(stats.ticks) / n << " avg, " << stats.minTicks << " min, " << stats.maxTicks
+        << " max\n"
+        << "bullets fired: " << stats.bulletsFired << " (" << double(stats.bulletsFired) / n << " avg)\n"
+        << "elapsed:       " << seconds << " s\n"
+        << "ticks/s:       " << (seconds > 0 ? stats.ticks / seconds : 0.0) << "\n"
+        << "matches/s:     " << (seconds > 0 ? stats.matches / seconds : 0.0) << "\n";
+    return 0;
+}
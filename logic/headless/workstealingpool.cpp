@@ -0,0 +1,100 @@
+#include "workstealingpool.h"
+
+#include <QThread>
+
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Tanks {
+
+namespace {
+
+    // 每個工作執行緒的任務區間 [begin, end)，獨佔快取行以避免偽共享
+    struct alignas(64) TaskRange {
+        std::mutex lock;
+        int        begin = 0;
+        int        end   = 0;
+    };
+
+} // namespace
+
+// 構造函數，執行緒數為 0 時使用 CPU 核心數
+WorkStealingPool::WorkStealingPool(int threads) :
+    _threads(threads > 0 ? threads : qMax(1, QThread::idealThreadCount()))
+{
+}
+
+// 執行所有任務並等待完成
+void WorkStealingPool::run(int tasks, const TaskFunction &fn, const WorkerFunction &finished)
+{
+    if (tasks <= 0) {
+        return;
+    }
+    const int                    workers = qMin(_threads, tasks);
+    std::unique_ptr<TaskRange[]> ranges(new TaskRange[workers]);
+    for (int w = 0; w < workers; w++) {
+        ranges[w].begin = int(qint64(tasks) * w / workers);
+        ranges[w].end   = int(qint64(tasks) * (w + 1) / workers);
+    }
+
+    auto loop = [&](int self) {
+        TaskRange &own = ranges[self];
+        for (;;) {
+            int task = -1;
+            {
+                std::lock_guard<std::mutex> guard(own.lock);
+                if (own.begin < own.end) {
+                    task = own.begin++;
+                }
+            }
+            if (task >= 0) {
+                fn(self, task);
+                continue;
+            }
+
+            // 自己的區間已空，從其他執行緒竊取剩餘區間的後半段
+            bool stolen = false;
+            for (int i = 1; i < workers && !stolen; i++) {
+                TaskRange &victim = ranges[(self + i) % workers];
+                int        from, to;
+                {
+                    std::lock_guard<std::mutex> guard(victim.lock);
+                    int                         left = victim.end - victim.begin;
+                    if (left <= 0) {
+                        continue;
+                    }
+                    from       = victim.end - (left + 1) / 2;
+                    to         = victim.end;
+                    victim.end = from;
+                }
+                std::lock_guard<std::mutex> guard(own.lock);
+                own.begin = from;
+                own.end   = to;
+                stolen    = true;
+            }
+            if (!stolen) {
+                return; // 任務不會再增加，所有區間皆空即可結束
+            }
+        }
+    };
+    auto work = [&](int self) {
+        loop(self);
+        if (finished) {
+            finished(self);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (int w = 1; w < workers; w++) {
+        threads.emplace_back(work, w);
+    }
+    work(0);
+    for (auto &t : threads) {
+        t.join();
+    }
+}
+
+} // namespace Tanks
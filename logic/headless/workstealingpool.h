@@ -0,0 +1,63 @@
+/*
+ Copyright (c) 2016, Sergey Ilinykh
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL IL'INYKH SERGEY BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef TANKS_WORKSTEALINGPOOL_H
+#define TANKS_WORKSTEALINGPOOL_H
+
+#include <QtGlobal>
+
+#include <functional>
+
+namespace Tanks {
+
+/**
+ * @brief The WorkStealingPool class
+ * Runs a fixed number of independent tasks on all cores. Every worker
+ * starts with a contiguous range of task indices and, once it runs dry,
+ * steals the upper half of another worker's remaining range.
+ */
+class WorkStealingPool {
+public:
+    typedef std::function<void(int worker, int task)> TaskFunction;
+    typedef std::function<void(int worker)>           WorkerFunction;
+
+    explicit WorkStealingPool(int threads = 0);
+
+    inline int threadCount() const { return _threads; }
+
+    // blocks until all tasks are done. The calling thread is worker 0.
+    // finished() is called on each worker's own thread when it runs out of work
+    void run(int tasks, const TaskFunction &fn, const WorkerFunction &finished = WorkerFunction());
+
+private:
+    int _threads;
+};
+
+} // namespace Tanks
+
+#endif // TANKS_WORKSTEALINGPOOL_H
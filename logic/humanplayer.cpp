@@ -8,7 +8,7 @@ namespace Tanks {
 
 // 人類玩家類的構造函數
 HumanPlayer::HumanPlayer(Game *game, int playerIndex) :
-    _game(game), _playerIndex(playerIndex), _lifes(3), _shooting(false)
+    _game(game), _playerIndex(playerIndex), _lifes(3), _shooting(false), _spawnPending(false)
 {
 }
 
@@ -18,9 +18,16 @@ int HumanPlayer::lifesCount() const { return _lifes; }
 // 開始遊戲時的初始化函數
 void HumanPlayer::start()
 {
-    _tank         = QSharedPointer<Tank>(new Tank(Friendly));
+    const auto &posList = _game->board()->friendlyStartPositions();
+    QPoint      pos     = posList[_playerIndex % posList.count()];
+    _spawnPending       = _game->board()->occupant(QRect(pos, Tank::size())) != nullptr;
+    if (_spawnPending) {
+        return; // 在 clockTick() 中重試
+    }
+    _tank         = QSharedPointer<Tank>(new Tank(_game->entities(), Friendly));
     _oldDirection = _tank->direction();
     moveToStart(); // 移動至起始位置
+    _game->board()->addOccupant(_tank.data());
     emit newTankAvailable(); // 發出新坦克可用的訊號
     // 連接坦克被摧毀的信號
     connect(_tank.data(), &Tank::tankDestroyed, this, &HumanPlayer::onTankDestroyed);
@@ -68,9 +75,11 @@ void HumanPlayer::stopFire() { _shooting = false; }
 void HumanPlayer::clockTick()
 {
     if (!_tank) {
+        if (_spawnPending) {
+            start();
+        }
         return; // 無坦克時不做任何事
     }
-    AbstractPlayer::clockTick();
 
     QRect             fmr;
     Board::BlockProps props;
@@ -83,8 +92,10 @@ void HumanPlayer::clockTick()
         props = _game->board()->rectProps(fmr);
     }
 
-    if (shouldMove && !(props & Board::TankObstackle)) {
+    if (shouldMove && !(props & Board::TankObstackle) && !_game->board()->occupant(fmr, _tank.data())) {
+        QRect from = _tank->geometry();
         _tank->move();
+        _game->board()->moveOccupant(_tank.data(), from);
         _oldDirection = _tank->direction();
     }
 
@@ -100,21 +111,35 @@ void HumanPlayer::onTankDestroyed()
         qDebug("Something went wrong");
         return;
     }
+    _game->board()->removeOccupant(_tank.data());
+    _tank.clear(); // 起始位置被佔據時 start() 會延後出場，被摧毀的坦克不能留到那時
     _lifes--;
     if (_lifes) {
         start(); // 重啟遊戲
-    } else {
-        _tank.clear(); // 清除坦克
     }
     emit lifeLost(); // 發出生命損失的訊號
 }
 
+// 恢復初始狀態的函數
+void HumanPlayer::reset()
+{
+    _tank.clear();
+    _lifes        = 3;
+    _shooting     = false;
+    _spawnPending = false;
+    _movingDir.clear();
+}
+
 // 摧毀所有的函數
 void HumanPlayer::killAll()
 {
     if (_tank) {
         _lifes = 1;
         _tank->selfDestroy();
+    } else if (_spawnPending) { // 還在等待出場的也算陣亡
+        _spawnPending = false;
+        _lifes        = 0;
+        emit lifeLost();
     }
 }
 
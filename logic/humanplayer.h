@@ -51,6 +51,7 @@ public:
 
     void clockTick();
     void killAll();
+    void reset(); // 新一局前恢復初始狀態，玩家物件跨局重用
 
 protected:
     void moveToStart();
@@ -63,6 +64,7 @@ private:
     int                  _playerIndex;
     int                  _lifes;
     bool                 _shooting;
+    bool                 _spawnPending; // 起始位置被其他坦克佔據，等待其離開
     Direction            _oldDirection;
     std::list<Direction> _movingDir;
 };
@@ -28,31 +28,38 @@
 #include <QDebug>
 #include <QImage>
 #include <QPainter>
+#include <QQuickWindow>
 #include <QStandardPaths>
 
 #include "abstractmaploader.h"
 #include "board.h"
+#include "bulletpool.h"
 #include "flag.h"
 #include "game.h"
 #include "qmlbridge.h"
 #include "qmlmapimageprovider.h"
-#include "tank.h"
+#include "tickprofiler.h"
+#include "tickscheduler.h"
 
 namespace Tanks {
 
 static int minBlockSize = 8; // 4px. minimal breakable part or minimal move
 
-QMLBridge::QMLBridge(QObject *parent) : QObject(parent), _qmlId(0)
+// 棋盤坐標轉換為場景坐標
+static inline QRect toScene(const QRect &r) { return QRect(r.topLeft() * minBlockSize, r.size() * minBlockSize); }
+
+QMLBridge::QMLBridge(QObject *parent) :
+    QObject(parent), _tankModel(new QMLEntityModel(this)), _bulletModel(new QMLEntityModel(this)),
+    _effectModel(new QMLEntityModel(this)), _eventCursor(0), _sounds(0), _boardVersion(0)
 {
     QMLMapImageProvider::registerBridge(this);
 
     _game = new Game(this);
     connect(_game, &Game::mapLoaded, this, &QMLBridge::mapLoaded);
-    connect(_game, &Game::newTank, this, &QMLBridge::newTankAvailable);
-
-    connect(_game, &Game::blockRemoved, this, &QMLBridge::removeBlock);
-    connect(_game, &Game::flagLost, this, &QMLBridge::flagChanged);
     connect(_game, &Game::statsChanged, this, &QMLBridge::statsChanged);
+    connect(_game->scheduler(), &TickScheduler::tickRateChanged, this, &QMLBridge::tickRateChanged);
+    connect(_game->scheduler(), &TickScheduler::timeScaleChanged, this, &QMLBridge::timeScaleChanged);
+    connect(_game->scheduler(), &TickScheduler::advanced, this, &QMLBridge::flushMoves);
     // connect(_game, &Game::playerRestarted, this, &QMLBridge::playerRestarted)
 
     connect(this, SIGNAL(qmlTankAction(int, int)), SLOT(humanTankAction(int, int)));
@@ -66,11 +73,7 @@ QImage QMLBridge::bushImage() const { return _bushImage; }
 
 QSize QMLBridge::boardImageSize() const { return _game->board()->size() * minBlockSize; }
 
-QRect QMLBridge::flagGeometry() const
-{
-    QRect g = _game->flag()->geometry();
-    return QRect(g.topLeft() * minBlockSize, g.size() * minBlockSize);
-}
+QRect QMLBridge::flagGeometry() const { return toScene(_game->flag()->geometry()); }
 
 QString QMLBridge::flagFile() const { return _game->flag()->isBroken() ? "img/flag_broken" : "img/flag"; }
 
@@ -85,12 +88,70 @@ QString QMLBridge::lifesStat() const
 
 void QMLBridge::setBridgeId(const QString &id) { _bridgeId = id; }
 
+QString QMLBridge::profilerReport() const { return _game->profiler()->report(); }
+
+double QMLBridge::tickRate() const { return _game->scheduler()->tickRate(); }
+
+void QMLBridge::setTickRate(double hz) { _game->scheduler()->setTickRate(hz); }
+
+double QMLBridge::timeScale() const { return _game->timeScale(); }
+
+void QMLBridge::setTimeScale(double scale) { _game->setTimeScale(scale); }
+
+QObject *QMLBridge::frameDriver() const { return _frameDriver.data(); }
+
+void QMLBridge::setFrameDriver(QObject *driver)
+{
+    auto window = qobject_cast<QQuickWindow *>(driver);
+    if (window == _frameDriver) {
+        return;
+    }
+    if (_frameDriver) {
+        disconnect(_frameDriver, &QQuickWindow::afterAnimating, this, &QMLBridge::frameAnimating);
+    }
+    _frameDriver = window;
+    if (window) {
+        connect(window, &QQuickWindow::afterAnimating, this, &QMLBridge::frameAnimating);
+        _game->scheduler()->setDriver(TickScheduler::ExternalDriver);
+        window->update();
+    } else {
+        _game->scheduler()->setDriver(TickScheduler::TimerDriver);
+    }
+    emit frameDriverChanged();
+}
+
+void QMLBridge::frameAnimating()
+{
+    _game->scheduler()->advance();
+    if (_frameDriver) {
+        _frameDriver->update(); // keep frames coming even when the scene is still
+    }
+}
+
 void QMLBridge::mapLoaded()
 {
     qDebug() << "Map loaded!";
 
+    _tanks.clear();
+    _bullets.clear();
+    _movedTanks.resize(0);
+    _tankModel->releaseAll();
+    _bulletModel->releaseAll();
+    _effectModel->releaseAll();
+    _sounds      = 0;
+    _eventCursor = _game->events()->head(); // the scene starts over, earlier events are of no use
+
     //_activeBlocks.clear();
 
+    renderTerrain();
+    emit mapRendered();
+}
+
+// 重新繪製地形圖層，場景中的坦克和子彈保持不變
+void QMLBridge::renderTerrain()
+{
+    _boardVersion = _game->board()->version();
+
     static const char *textures[LastMapObjectType] = {
         0, ":/img/concrete", ":/img/brick", ":/img/bush", ":/img/ice", ":/img/water",
     };
@@ -113,23 +174,29 @@ void QMLBridge::mapLoaded()
         }
     }
 
-    _lowerMapImage = QImage(_game->board()->size() * minBlockSize, QImage::Format_ARGB32);
+    QSize imageSize = _game->board()->size() * minBlockSize;
+    if (_lowerMapImage.size() != imageSize) { // on restart the same buffers are cleared and reused
+        _lowerMapImage = QImage(imageSize, QImage::Format_ARGB32);
+        _bushImage     = QImage(imageSize, QImage::Format_ARGB32);
+    }
     _lowerMapImage.fill(0);
     QPainter lowerPainter(&_lowerMapImage);
 
-    _bushImage = QImage(_game->board()->size() * minBlockSize, QImage::Format_ARGB32);
     _bushImage.fill(0);
     QPainter bushPainter(&_bushImage);
 
-    Board::Iterator it = _game->board()->iterate();
-    while (it.isValid()) {
-        QPainter *painter = *it == Bush ? &bushPainter : &lowerPainter;
-        QImage   &probe   = probes[*it];
-        QPoint    pos     = it.pos() * minBlockSize;
-        int       probeX  = pos.x() % (_game->board()->blockDivider() * minBlockSize);
-        int       probeY  = pos.y() % (_game->board()->blockDivider() * minBlockSize);
-        painter->drawImage(pos, probe, QRect(probeX, probeY, minBlockSize, minBlockSize));
-        ++it;
+    // textures are tiled from the image origin, so a whole run of blocks is one fill
+    QVector<QBrush> brushes(LastMapObjectType);
+    for (int i = 0; i < LastMapObjectType; i++) {
+        brushes[i] = QBrush(probes[i]);
+    }
+    for (Board::RunIterator it = _game->board()->runs(); it.isValid(); ++it) {
+        if (it->type == Nothing) {
+            continue; // transparent
+        }
+        QPainter *painter = it->type == Bush ? &bushPainter : &lowerPainter;
+        QRect     rect(it->pos * minBlockSize, QSize(it->length, 1) * minBlockSize);
+        painter->fillRect(rect, brushes[it->type]);
     }
 
     // that's the most easy way. QQuickImageProvider is just a holy crap (I'm sorry)
@@ -137,85 +204,149 @@ void QMLBridge::mapLoaded()
     // more complicated even if idealogically more correct.
     // lowerLayer.save(_lowerFilename);
     // bushLayer.save(_bushFilename);
-
-    emit mapRendered();
-}
-
-void QMLBridge::newTankAvailable(QObject *obj)
-{
-    Tank *tank = qobject_cast<Tank *>(obj);
-
-    connect(tank, &Tank::fired, this, &QMLBridge::newBulletAvailable);
-    connect(tank, &Tank::moved, this, &QMLBridge::moveTank);
-    connect(tank, &Tank::tankDestroyed, this, &QMLBridge::destroyTank);
-
-    QString id = QString("tank") + QString::number(_qmlId++);
-    //_activeBlocks.insert(id, tank.dynamicCast<Block>());
-    tank->setProperty("qmlid", id);
-    emit newTank(tank2variant(tank));
 }
 
-void QMLBridge::newBulletAvailable()
+// 讀取上一批以來的遊戲事件並更新場景模型，坦克的移動合併為每批一次
+void QMLBridge::drainEvents()
 {
-    Bullet *bullet = qobject_cast<Tank *>(sender())->bullet().data();
-
-    connect(bullet, &DynamicBlock::moved, this, &QMLBridge::moveBullet);
-
-    QString id = QString("bullet") + QString::number(_qmlId++);
-    //_activeBlocks.insert(id, tank.dynamicCast<Block>());
-    bullet->setProperty("qmlid", id);
-
-    QVariantMap vb;
-    vb["id"] = id;
-    // vb["affinity"] = bullet->affinity();
-    vb["direction"] = (int)bullet->direction();
-    QRect geom      = bullet->geometry();
-    vb["geometry"]  = QRect(geom.topLeft() * minBlockSize, geom.size() * minBlockSize);
+    _events.resize(0);
+    if (!_game->events()->read(_eventCursor, _events)) {
+        qWarning("QMLBridge: game events were lost, the scene may be out of sync");
+    }
 
-    connect(bullet, &Bullet::detonated, this, &QMLBridge::detonateBullet);
-    emit newBullet(vb);
-}
+    for (int i = 0; i < _events.size(); i++) {
+        const GameEvent &e = _events.at(i);
+        switch (e.type) {
+        case GameEvent::TankSpawned: {
+            TankView view;
+            view.row       = _tankModel->acquire();
+            view.moveEvent = -1;
+            _tanks.insert(e.subject, view);
+
+            QMLEntityModel::Entry &t = _tankModel->entry(view.row);
+            t.geometry               = toScene(e.rect());
+            t.direction              = e.direction;
+            t.affinity               = e.affinity;
+            t.variant                = e.detail;
+            break;
+        }
+        case GameEvent::TankMoved:
+            if (TankView *view = _tanks.find(e.subject)) {
+                if (view->moveEvent < 0) {
+                    _movedTanks.append(e.subject);
+                }
+                view->moveEvent = i;
+            }
+            break;
+        case GameEvent::TankDestroyed:
+            if (TankView *view = _tanks.find(e.subject)) {
+                addExplosion(e.rect());
+                _tankModel->release(view->row);
+                _tanks.remove(e.subject); // its pending move is dropped with it
+            }
+            break;
+        case GameEvent::BulletFired: {
+            BulletView view;
+            view.row = _bulletModel->acquire();
+            view.pos = QPoint(e.x, e.y);
+            _bullets.insert(e.subject, view);
+
+            QMLEntityModel::Entry &b = _bulletModel->entry(view.row);
+            b.geometry               = toScene(QRect(view.pos, Bullet::size()));
+            b.direction              = e.direction;
+            _sounds |= 1 << ShotSound;
+            break;
+        }
+        case GameEvent::BulletDetonated:
+            if (BulletView *view = _bullets.find(e.subject)) {
+                // the bullet may have moved since the last flush, hide it where it hit
+                _bulletModel->entry(view->row).geometry = toScene(QRect(QPoint(e.x, e.y), Bullet::size()));
+                _bulletModel->release(view->row);
+                _bullets.remove(e.subject);
+                _sounds |= 1 << (NoDamageSound + e.detail);
+            }
+            break;
+        case GameEvent::FlagLost:
+            addExplosion(e.rect());
+            emit flagChanged();
+            break;
+        default: // armor and terrain are rendered from the game state
+            break;
+        }
+    }
 
-void QMLBridge::moveTank()
-{
-    auto tank = qobject_cast<Tank *>(sender());
-    emit tankUpdated(tank2variant(tank));
+    foreach (Handle handle, _movedTanks) {
+        TankView *view = _tanks.find(handle);
+        if (!view || view->moveEvent < 0) {
+            continue; // destroyed in this batch
+        }
+        const GameEvent       &e = _events.at(view->moveEvent);
+        QMLEntityModel::Entry &t = _tankModel->entry(view->row);
+        t.geometry               = toScene(e.rect());
+        t.direction              = e.direction;
+        t.frame ^= 1; // tracks roll
+        view->moveEvent = -1;
+    }
+    _movedTanks.resize(0);
 }
 
-void QMLBridge::destroyTank() { emit tankDestroyed(sender()->property("qmlid").toString()); }
-
-void QMLBridge::moveBullet()
+// 在 geometry（棋盤坐標）處播放一次大爆炸
+void QMLBridge::addExplosion(const QRect &geometry)
 {
-    auto bullet = qobject_cast<Bullet *>(sender());
-    // qDebug() << "New position: " << bullet->geometry().topLeft() * minBlockSize;
-    emit bulletMoved(bullet->property("qmlid").toString(), bullet->geometry().topLeft() * minBlockSize);
+    int row                           = _effectModel->acquire();
+    _effectModel->entry(row).geometry = toScene(geometry);
 }
 
-void QMLBridge::detonateBullet()
+void QMLBridge::flushMoves()
 {
-    auto bullet = qobject_cast<Bullet *>(sender());
-    emit bulletDetonated(bullet->property("qmlid").toString(), (int)bullet->explosionType());
-}
+    TickProfiler::Scope scope(_game->profiler(), TickProfiler::BridgePhase);
+    drainEvents();
+
+    const BulletPool &pool = _game->bullets();
+    for (int i = 0; i < pool.count(); i++) {
+        BulletView *view = _bullets.find(pool.handle(i));
+        if (!view) {
+            continue;
+        }
+        QPoint pos = pool.position(i);
+        if (pos != view->pos) {
+            view->pos                               = pos;
+            _bulletModel->entry(view->row).geometry = toScene(QRect(pos, Bullet::size()));
+        }
+    }
+    _tankModel->flush();
+    _bulletModel->flush();
+    _effectModel->flush();
+    for (int sound = ShotSound; _sounds; sound++, _sounds >>= 1) {
+        if (_sounds & 1) {
+            emit soundRequested(sound);
+        }
+    }
 
-QVariant QMLBridge::tank2variant(Tank *tank)
-{
-    QVariantMap vtank;
-    vtank["id"]        = tank->property("qmlid").toString();
-    vtank["affinity"]  = (int)tank->affinity();
-    vtank["variant"]   = tank->variant();
-    vtank["direction"] = (int)tank->direction();
-    QRect tankGeom     = tank->geometry();
-    vtank["geometry"]  = QRect(tankGeom.topLeft() * minBlockSize, tankGeom.size() * minBlockSize);
-    return vtank;
+    // terrain changes of the whole batch, coalesced by the board
+    QVector<QRect> regions;
+    if (!_game->board()->dirtyRegions(_boardVersion, regions)) {
+        renderTerrain(); // history is gone, repaint the whole terrain
+        emit terrainRendered();
+        return;
+    }
+    _boardVersion = _game->board()->version();
+    foreach (const QRect &r, regions) {
+        for (Board::RunIterator it = _game->board()->runs(r); it.isValid(); ++it) {
+            if (it->type != Nothing) { // blocks came back (snapshot restore), QML layers can only erase
+                renderTerrain();
+                emit terrainRendered();
+                return;
+            }
+        }
+    }
+    foreach (const QRect &r, regions) {
+        emit blockRemoved(QRect(r.topLeft() * minBlockSize, r.size() * minBlockSize));
+    }
 }
 
 void QMLBridge::restart(int playersCount) { _game->start(playersCount); }
 
-void QMLBridge::removeBlock(const QRect &r)
-{
-    emit blockRemoved(QRect(r.topLeft() * minBlockSize, r.size() * minBlockSize));
-}
-
 void QMLBridge::humanTankAction(int player, int key)
 {
     // qDebug() << "Catched start!";
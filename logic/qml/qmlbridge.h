@@ -30,15 +30,20 @@
 
 #include <QImage>
 #include <QObject>
+#include <QPointer>
 #include <QTemporaryDir>
 #include <QVariant>
 
 #include "block.h"
+#include "gameevents.h"
+#include "qmlentitymodel.h"
+#include "slotmap.h"
+
+class QQuickWindow;
 
 namespace Tanks {
 
 class Game;
-class Tank;
 
 class QMLBridge : public QObject {
     Q_OBJECT
@@ -48,8 +53,19 @@ class QMLBridge : public QObject {
     Q_PROPERTY(QString flagFile READ flagFile NOTIFY flagChanged)
 
     Q_PROPERTY(QString lifesStat READ lifesStat NOTIFY statsChanged)
+    Q_PROPERTY(double tickRate READ tickRate WRITE setTickRate NOTIFY tickRateChanged)
+    Q_PROPERTY(double timeScale READ timeScale WRITE setTimeScale NOTIFY timeScaleChanged)
+    Q_PROPERTY(QObject *frameDriver READ frameDriver WRITE setFrameDriver NOTIFY frameDriverChanged)
+
+    Q_PROPERTY(Tanks::QMLEntityModel *tanks READ tanks CONSTANT)
+    Q_PROPERTY(Tanks::QMLEntityModel *bullets READ bullets CONSTANT)
+    Q_PROPERTY(Tanks::QMLEntityModel *effects READ effects CONSTANT)
 
 public:
+    // 爆炸音效的順序與 Bullet::ExplosionType 相同
+    enum Sound { ShotSound, NoDamageSound, BrickSound, TankSound, FlagSound };
+    Q_ENUM(Sound)
+
     explicit QMLBridge(QObject *parent = 0);
     QImage lowerMapImage() const;
     QImage bushImage() const;
@@ -62,23 +78,46 @@ public:
     inline QString bridgeId() const { return _bridgeId; }
     void           setBridgeId(const QString &id);
 
+    Q_INVOKABLE QString profilerReport() const;
+
+    double tickRate() const;
+    void   setTickRate(double hz);
+
+    // 0 表示盡可能快
+    double timeScale() const;
+    void   setTimeScale(double scale);
+
+    // 設置 QQuickWindow 後，遊戲週期由它的每一幀驅動
+    QObject *frameDriver() const;
+    void     setFrameDriver(QObject *driver);
+
+    // 場景中的物件，由 Repeater 顯示。行在物件消失後重用
+    inline QMLEntityModel *tanks() const { return _tankModel; }
+    inline QMLEntityModel *bullets() const { return _bulletModel; }
+    inline QMLEntityModel *effects() const { return _effectModel; } // 爆炸，QML 播放完畢後釋放
+
 private:
-    QVariant tank2variant(Tank *tank);
+    struct TankView {
+        int row; // 在 _tankModel 中的行
+        int moveEvent; // 本批最後一次移動在 _events 中的位置，沒有時為 -1
+    };
+
+    void drainEvents();
+    void renderTerrain();
+    void addExplosion(const QRect &geometry);
 
 signals:
     void mapRendered();
+    void terrainRendered(); // 只有地形圖層被重新繪製
     void statsChanged();
     void blockRemoved(QRect block);
 
-    void newTank(QVariant tank);
-    void tankUpdated(QVariant tank);
-    void tankDestroyed(QString id);
-
-    void newBullet(QVariant bullet);
-    void bulletMoved(QString id, QPoint pos);
-    void bulletDetonated(QString id, int reason);
+    void soundRequested(int sound); // 每批每種音效最多一次
 
     void flagChanged();
+    void tickRateChanged();
+    void timeScaleChanged();
+    void frameDriverChanged();
 
     void qmlTankAction(int player, int key);
     void qmlTankActionStop(int player, int key);
@@ -92,23 +131,37 @@ private slots:
 
     void mapLoaded();
 
-    void newTankAvailable(QObject *obj);
-    void newBulletAvailable();
-    void moveTank();
-    void removeBlock(const QRect &r);
-    void moveBullet();
-    void destroyTank();
-    void detonateBullet();
+    void frameAnimating();
+    void flushMoves();
 
 private:
     QString       _bridgeId;
     QTemporaryDir _tmpDir;
     Game         *_game;
 
-    QImage _lowerMapImage;
-    QImage _bushImage;
+    QPointer<QQuickWindow> _frameDriver;
+
+    struct BulletView {
+        int    row; // 在 _bulletModel 中的行
+        QPoint pos; // 已發送給 QML 的位置
+    };
+
+    QMLEntityModel *_tankModel;
+    QMLEntityModel *_bulletModel;
+    QMLEntityModel *_effectModel;
+
+    HandleTable<TankView>   _tanks; // 按實體句柄
+    HandleTable<BulletView> _bullets; // 按子彈池句柄
+    QVector<Handle>         _movedTanks; // 本批移動過的坦克，批次結束時只發送最終狀態
+
+    QVector<GameEvent> _events; // 讀取事件的緩衝，各批之間重用
+    quint64            _eventCursor; // 已處理到的遊戲事件
+    int                _sounds; // 本批要播放的音效，按 Sound 的位
+
+    QImage  _lowerMapImage;
+    QImage  _bushImage;
+    quint64 _boardVersion; // 已發送給 QML 的地形版本
 
-    int _qmlId;
     // QHash<QString, QWeakPointer<Block>> _activeBlocks;
 };
 
@@ -0,0 +1,170 @@
+/*
+ Copyright (c) 2016, Sergey Ilinykh
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL IL'INYKH SERGEY BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "qmlentitymodel.h"
+
+#include <limits>
+
+namespace Tanks {
+
+// QMLEntityModel 類的構造函數
+QMLEntityModel::QMLEntityModel(QObject *parent) :
+    QAbstractListModel(parent), _dirtyFirst(std::numeric_limits<int>::max()), _dirtyLast(-1)
+{
+}
+
+// 佔用一行，優先重用已釋放的行，只有在同時存在的物件創下新高時才增加行數
+int QMLEntityModel::acquire()
+{
+    int row;
+    if (_freeRows.isEmpty()) {
+        row = _entries.size();
+        beginInsertRows(QModelIndex(), row, row);
+        _entries.append(Entry());
+        endInsertRows();
+    } else {
+        row = _freeRows.takeLast();
+    }
+    Entry &e = entry(row);
+    e.frame  = 0;
+    e.used   = true;
+    e.serial++;
+    _activating.append(row);
+    return row;
+}
+
+// 釋放一行，立即在 QML 中隱藏
+void QMLEntityModel::release(int row)
+{
+    if (row < 0 || row >= _entries.size() || !_entries.at(row).used) {
+        return;
+    }
+    _entries[row].used = false;
+    _freeRows.append(row);
+    _activating.removeOne(row);
+    if (_entries.at(row).active) {
+        _entries[row].active = false;
+        QModelIndex i        = index(row);
+        emit dataChanged(i, i, QVector<int>() << ActiveRole);
+    }
+}
+
+// 由 QML 調用的釋放，只在該行仍是 serial 那一次佔用時生效
+void QMLEntityModel::release(int row, int serial)
+{
+    if (row >= 0 && row < _entries.size() && _entries.at(row).serial == quint16(serial)) {
+        release(row);
+    }
+}
+
+// 釋放所有行，例如載入新地圖時
+void QMLEntityModel::releaseAll()
+{
+    _freeRows.resize(0);
+    _activating.resize(0);
+    for (int row = _entries.size() - 1; row >= 0; row--) {
+        _entries[row].active = false;
+        _entries[row].used   = false;
+        _freeRows.append(row);
+    }
+    _dirtyFirst = std::numeric_limits<int>::max();
+    _dirtyLast  = -1;
+    if (!_entries.isEmpty()) {
+        emit dataChanged(index(0), index(_entries.size() - 1), QVector<int>() << ActiveRole);
+    }
+}
+
+// 通知本批的所有修改：先送出位置等狀態，再顯示新佔用的行
+void QMLEntityModel::flush()
+{
+    if (_dirtyFirst <= _dirtyLast) {
+        static const QVector<int> stateRoles = QVector<int>() << XRole << YRole << WidthRole << HeightRole
+                                                              << DirectionRole << AffinityRole << VariantRole
+                                                              << FrameRole << SerialRole;
+        emit dataChanged(index(_dirtyFirst), index(_dirtyLast), stateRoles);
+        _dirtyFirst = std::numeric_limits<int>::max();
+        _dirtyLast  = -1;
+    }
+    foreach (int row, _activating) {
+        _entries[row].active = true;
+        QModelIndex i        = index(row);
+        emit dataChanged(i, i, QVector<int>() << ActiveRole);
+    }
+    _activating.resize(0);
+}
+
+int QMLEntityModel::rowCount(const QModelIndex &parent) const { return parent.isValid() ? 0 : _entries.size(); }
+
+QVariant QMLEntityModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= _entries.size()) {
+        return QVariant();
+    }
+    const Entry &e = _entries.at(index.row());
+    switch (role) {
+    case ActiveRole:
+        return e.active;
+    case XRole:
+        return e.geometry.x();
+    case YRole:
+        return e.geometry.y();
+    case WidthRole:
+        return e.geometry.width();
+    case HeightRole:
+        return e.geometry.height();
+    case DirectionRole:
+        return int(e.direction);
+    case AffinityRole:
+        return int(e.affinity);
+    case VariantRole:
+        return int(e.variant);
+    case FrameRole:
+        return int(e.frame);
+    case SerialRole:
+        return int(e.serial);
+    }
+    return QVariant();
+}
+
+QHash<int, QByteArray> QMLEntityModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles[ActiveRole]    = "active";
+    roles[XRole]         = "x";
+    roles[YRole]         = "y";
+    roles[WidthRole]     = "width";
+    roles[HeightRole]    = "height";
+    roles[DirectionRole] = "direction";
+    roles[AffinityRole]  = "affinity";
+    roles[VariantRole]   = "variant";
+    roles[FrameRole]     = "frame";
+    roles[SerialRole]    = "serial";
+    return roles;
+}
+
+} // namespace Tanks
@@ -0,0 +1,107 @@
+/*
+ Copyright (c) 2016, Sergey Ilinykh
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL IL'INYKH SERGEY BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef TANKS_QMLENTITYMODEL_H
+#define TANKS_QMLENTITYMODEL_H
+
+#include <QAbstractListModel>
+#include <QRect>
+#include <QVector>
+
+namespace Tanks {
+
+/**
+ * @brief The QMLEntityModel class
+ * Scene objects of one kind (tanks, bullets or effects) for a QML Repeater.
+ * Rows are never removed: a released row only turns inactive and is handed
+ * out again by the next acquire(), so the delegates QML created for the
+ * busiest moment of the game are recycled and a new shot costs no QML
+ * object. Changes made through entry() are announced in flush(), once per
+ * batch; a newly acquired row gets its position before it is shown, so
+ * delegates can animate moves without animating a recycled row's jump.
+ */
+class QMLEntityModel : public QAbstractListModel {
+    Q_OBJECT
+public:
+    enum Roles {
+        ActiveRole = Qt::UserRole + 1,
+        XRole,
+        YRole,
+        WidthRole,
+        HeightRole,
+        DirectionRole,
+        AffinityRole,
+        VariantRole,
+        FrameRole,
+        SerialRole
+    };
+
+    struct Entry {
+        QRect   geometry; // 場景坐標
+        quint8  direction = 0;
+        quint8  affinity  = 0;
+        quint8  variant   = 0;
+        quint8  frame     = 0; // 動畫幀
+        quint16 serial    = 0; // 每次被佔用時加一
+        bool    active    = false; // QML 中可見
+        bool    used      = false; // 已被佔用，可能尚未顯示
+    };
+
+    explicit QMLEntityModel(QObject *parent = 0);
+
+    int  acquire(); // 佔用一行，flush() 時顯示
+    void release(int row);
+    void releaseAll();
+
+    inline Entry &entry(int row) // 修改的內容在 flush() 時通知 QML
+    {
+        _dirtyFirst = qMin(_dirtyFirst, row);
+        _dirtyLast  = qMax(_dirtyLast, row);
+        return _entries[row];
+    }
+
+    void flush();
+
+    // 由 QML 在效果播放完畢時調用，serial 防止釋放已被重新佔用的行
+    Q_INVOKABLE void release(int row, int serial);
+
+    int                    rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant               data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    QHash<int, QByteArray> roleNames() const;
+
+private:
+    QVector<Entry> _entries;
+    QVector<int>   _freeRows;
+    QVector<int>   _activating; // 本批新佔用的行
+    int            _dirtyFirst;
+    int            _dirtyLast;
+};
+
+} // namespace Tanks
+
+#endif // TANKS_QMLENTITYMODEL_H
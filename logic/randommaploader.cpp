@@ -1,4 +1,5 @@
 #include "randommaploader.h"
+#include "randomstreams.h"
 #include "tank.h"
 
 #include <QDateTime>
@@ -8,54 +9,120 @@
 
 namespace Tanks {
 
+// 各種地形的形狀參數，順序即生成順序
+static const int referenceArea = 50 * 50; // count 所對應的地圖面積
+static const int sectorSize    = 32; // 流式模式下扇區的邊長（地圖塊）
+static const int maxShapeSize  = 20;
+
 // 隨機地圖加載器的構造函數，初始化棋盤的寬度和高度
-RandomMapLoader::RandomMapLoader() : boardWidth(50), boardHeight(50) { }
+RandomMapLoader::RandomMapLoader() : boardWidth(50), boardHeight(50), enemyTanksCount(20), streaming(false), seed(0)
+{
+    setRandomSeed(QRandomGenerator::global()->generate64());
+}
+
+// 設置隨機種子，同一種子生成相同的地圖與敵方坦克
+void RandomMapLoader::setRandomSeed(quint64 seed)
+{
+    this->seed = seed;
+    rng        = RandomStreams::generator(seed, RandomStreams::MapLoaderStream);
+}
+
+// 設置棋盤尺寸（以地圖塊為單位）
+void RandomMapLoader::setBoardSize(const QSize &size)
+{
+    boardWidth  = qMax(10, size.width()); // 第一個友方出生點在 w / 2 - 5，更窄時會落在棋盤外
+    boardHeight = qMax(8, size.height());
+}
+
+// 設置每局敵方坦克數量
+void RandomMapLoader::setEnemyTanksCount(int count) { enemyTanksCount = qMax(0, count); }
+
+// 設置流式模式
+void RandomMapLoader::setStreaming(bool streaming) { this->streaming = streaming; }
+
+// 流式模式下支持按區域加載
+bool RandomMapLoader::supportsRegions() const { return streaming; }
+
+// 形狀參數表
+static const struct {
+    MapObjectType type;
+    int           minSize;
+    int           maxSize;
+    int           count; // 每 50x50 地圖塊的數量
+} shapeKinds[] = {
+    { Brick, 4, maxShapeSize, 20 }, // 磚塊
+    { Concrete, 3, 8, 10 }, // 混凝土
+    { Water, 3, 8, 10 }, // 水域
+    { Ice, 3, 8, 10 }, // 冰面
+    { Bush, 3, 8, 20 }, // 灌木叢
+};
 
 // 打開地圖加載器，初始化各種地形和物體的隊列
 bool RandomMapLoader::open()
 {
-    int i;
-
     shapesQueue.clear();
     objectQueue.clear();
-
-           // 初始化磚塊
-    for (i = 0; i < 20; i++) {
-        shapesQueue.enqueue({ Brick, 4, 20 });
+    if (streaming) {
+        return true; // 由 loadRegion() 按需生成
     }
 
-           // 初始化混凝土
-    for (i = 0; i < 10; i++) {
-        shapesQueue.enqueue({ Concrete, 3, 8 });
-    }
-
-           // 初始化水域
-    for (i = 0; i < 10; i++) {
-        shapesQueue.enqueue({ Water, 3, 8 });
+    for (const auto &kind : shapeKinds) {
+        for (int i = 0; i < kind.count; i++) {
+            shapesQueue.enqueue({ kind.type, kind.minSize, kind.maxSize });
+        }
     }
+    return true;
+}
 
-           // 初始化冰面
-    for (i = 0; i < 10; i++) {
-        shapesQueue.enqueue({ Ice, 3, 8 });
+// 按區域生成地圖物體。每個扇區的形狀只取決於種子和扇區位置，與加載順序無關
+QList<MapObject> RandomMapLoader::loadRegion(const QRect &region)
+{
+    QList<MapObject> ret;
+    QRect            board(0, 0, boardWidth, boardHeight);
+    QRect            area = region & board;
+    if (!streaming || area.isEmpty()) {
+        return ret;
     }
 
-           // 初始化灌木叢
-    for (i = 0; i < 20; i++) {
-        shapesQueue.enqueue({ Bush, 3, 8 });
+    // 形狀中心在扇區內，但可以伸出扇區最多 maxShapeSize / 2
+    QRect reach    = area.adjusted(-maxShapeSize, -maxShapeSize, maxShapeSize, maxShapeSize) & board;
+    int   sectorsX = (boardWidth + sectorSize - 1) / sectorSize;
+    for (int sy = reach.top() / sectorSize; sy <= reach.bottom() / sectorSize; sy++) {
+        for (int sx = reach.left() / sectorSize; sx <= reach.right() / sectorSize; sx++) {
+            quint32           stream = RandomStreams::MapRegionStream + sy * sectorsX + sx;
+            QRect             sector = QRect(sx * sectorSize, sy * sectorSize, sectorSize, sectorSize) & board;
+            QRandomGenerator  srng   = RandomStreams::generator(seed, stream);
+            QQueue<MapObject> objects;
+            for (const auto &kind : shapeKinds) {
+                int count = (kind.count * sector.width() * sector.height() + referenceArea / 2) / referenceArea;
+                for (int i = 0; i < count; i++) {
+                    generateShape({ kind.type, kind.minSize, kind.maxSize }, srng, sector, objects);
+                }
+            }
+            for (const auto &object : objects) {
+                QRect g = object.geometry & area;
+                if (!g.isEmpty()) {
+                    ret.append(MapObject { g, object.type });
+                }
+            }
+        }
     }
-    return true;
+    return ret;
 }
 
 // 生成隨機形狀的函數
-void RandomMapLoader::generateShape(const PendingShape &shape)
+void RandomMapLoader::generateShape(const PendingShape &shape,
+                                    QRandomGenerator   &rng,
+                                    const QRect        &area,
+                                    QQueue<MapObject>  &objectQueue) const
 {
     // 生成隨機大小和位置
-    int rndWidth  = qMax(shape.minSize, QRandomGenerator::global()->bounded(shape.maxSize + 1));
-    int rndHeight = qMax(shape.minSize, QRandomGenerator::global()->bounded(shape.maxSize + 1));
-    int rndLeft   = QRandomGenerator::global()->bounded(boardWidth) - rndWidth / 2;
-    int rndTop    = QRandomGenerator::global()->bounded(boardHeight) - rndHeight / 2;
+    int rndWidth  = qMax(shape.minSize, rng.bounded(shape.maxSize + 1));
+    int rndHeight = qMax(shape.minSize, rng.bounded(shape.maxSize + 1));
+    int rndLeft   = area.left() + rng.bounded(area.width()) - rndWidth / 2;
+    int rndTop    = area.top() + rng.bounded(area.height()) - rndHeight / 2;
 
-    int shapeVariant = QRandomGenerator::global()->bounded(6); // 偏重於橢圓形
+    int shapeVariant = rng.bounded(6); // 偏重於橢圓形
     switch (shapeVariant) {
     case 0:
         // 垂直條
@@ -117,7 +184,7 @@ MapObject RandomMapLoader::next()
 {
     if (objectQueue.isEmpty()) {
         Q_ASSERT(!shapesQueue.isEmpty());
-        generateShape(shapesQueue.dequeue());
+        generateShape(shapesQueue.dequeue(), rng, QRect(0, 0, boardWidth, boardHeight), objectQueue);
     }
     return objectQueue.dequeue();
 }
@@ -126,9 +193,9 @@ MapObject RandomMapLoader::next()
 QList<quint8> RandomMapLoader::enemyTanks() const
 {
     QList<quint8> ret;
-    ret.reserve(10);
-    for (int i = 0; i < 20; i++) {
-        int val = QRandomGenerator::global()->bounded(12);
+    ret.reserve(enemyTanksCount);
+    for (int i = 0; i < enemyTanksCount; i++) {
+        int val = rng.bounded(12);
         if (val > 10) { // 11
             ret.append(Tank::ArmoredTank);
         } else if (val > 7) { // 8,9
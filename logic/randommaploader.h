@@ -4,6 +4,7 @@
 #include "abstractmaploader.h"
 
 #include <QQueue>
+#include <QRandomGenerator>
 
 namespace Tanks {
 
@@ -27,17 +28,35 @@ public:
     QList<quint8> enemyTanks() const;
     QList<QPoint> enemyStartPositions() const;
     QList<QPoint> friendlyStartPositions() const;
-    QPoint        flagPosition() const;
+    QPoint           flagPosition() const;
+    void             setRandomSeed(quint64 seed);
+    bool             supportsRegions() const;
+    QList<MapObject> loadRegion(const QRect &region);
+
+           // 地圖生成參數
+    void setBoardSize(const QSize &size);
+    void setEnemyTanksCount(int count);
+
+           // 流式模式：地圖按 32x32 地圖塊的扇區生成，每個扇區有獨立的隨機數流，
+           // 因此任意區域都可以單獨且重複地生成。open() 不再生成整張地圖
+    void setStreaming(bool streaming);
 
 private:
-    // 生成形狀的私有函數
-    void generateShape(const PendingShape &shape);
+    // 在 area 內生成一個隨機形狀
+    void generateShape(const PendingShape &shape,
+                       QRandomGenerator   &rng,
+                       const QRect        &area,
+                       QQueue<MapObject>  &objectQueue) const;
 
 private:
-    int                  boardWidth; // 棋盤的寬度
-    int                  boardHeight; // 棋盤的高度
-    QQueue<PendingShape> shapesQueue; // 待生成形狀的隊列
-    QQueue<MapObject>    objectQueue; // 地圖物體的隊列
+    int                      boardWidth; // 棋盤的寬度
+    int                      boardHeight; // 棋盤的高度
+    int                      enemyTanksCount; // 每局敵方坦克數量
+    bool                     streaming; // 按區域生成
+    quint64                  seed; // 區域生成所用的種子
+    QQueue<PendingShape>     shapesQueue; // 待生成形狀的隊列
+    QQueue<MapObject>        objectQueue; // 地圖物體的隊列
+    mutable QRandomGenerator rng; // 本加載器獨立的隨機數流
 };
 
 } // namespace Tanks
@@ -0,0 +1,77 @@
+/*
+ Copyright (c) 2016, Sergey Ilinykh
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL IL'INYKH SERGEY BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef TANKS_RANDOMSTREAMS_H
+#define TANKS_RANDOMSTREAMS_H
+
+#include <QRandomGenerator>
+
+namespace Tanks {
+
+/**
+ * @brief The RandomStreams class
+ * Derives independent generator streams from a single 64-bit match seed.
+ * Every consumer owns its generator, so no state is shared between games
+ * or threads and any match is reproducible from its seed.
+ */
+class RandomStreams {
+public:
+    enum Stream {
+        NextMatchStream = 0, // seed of the following match
+        MapLoaderStream = 1,
+        AIStream        = 2,
+        AIPlayerStream  = 16,      // + player index
+        MapRegionStream = 0x10000, // + map sector index
+    };
+
+    static inline quint64 splitMix64(quint64 &state)
+    {
+        quint64 z = (state += Q_UINT64_C(0x9e3779b97f4a7c15));
+        z         = (z ^ (z >> 30)) * Q_UINT64_C(0xbf58476d1ce4e5b9);
+        z         = (z ^ (z >> 27)) * Q_UINT64_C(0x94d049bb133111eb);
+        return z ^ (z >> 31);
+    }
+
+    static inline quint64 streamSeed(quint64 seed, quint32 stream)
+    {
+        quint64 state = seed ^ (Q_UINT64_C(0xd1b54a32d192ed03) * (stream + 1));
+        return splitMix64(state);
+    }
+
+    static inline QRandomGenerator generator(quint64 seed, quint32 stream)
+    {
+        quint64 state = streamSeed(seed, stream);
+        quint64 a     = splitMix64(state);
+        quint64 b     = splitMix64(state);
+        quint32 seq[] = { quint32(a), quint32(a >> 32), quint32(b), quint32(b >> 32) };
+        return QRandomGenerator(seq, 4);
+    }
+};
+
+} // namespace Tanks
+
+#endif // TANKS_RANDOMSTREAMS_H
@@ -0,0 +1,34 @@
+#include "slotmap.h"
+
+namespace Tanks {
+
+// 分配一個指向 index 的句柄，優先重用空閒槽位
+Handle SlotMap::insert(int index)
+{
+    int slot;
+    if (_freeSlots.isEmpty()) {
+        slot = _slots.size();
+        Q_ASSERT(slot <= IndexMask);
+        _slots.append(Slot());
+    } else {
+        slot = _freeSlots.takeLast();
+    }
+    _slots[slot].index = index;
+    return (Handle(_slots.at(slot).generation) << IndexBits) | Handle(slot);
+}
+
+// 使句柄失效，槽位的代數加一後留給之後的 insert()
+void SlotMap::remove(Handle handle)
+{
+    if (indexOf(handle) < 0) {
+        return;
+    }
+    Slot &s = _slots[slotOf(handle)];
+    s.index = -1;
+    if (!++s.generation) {
+        s.generation = 1;
+    }
+    _freeSlots.append(slotOf(handle));
+}
+
+} // namespace Tanks
@@ -0,0 +1,124 @@
+/*
+ Copyright (c) 2016, Sergey Ilinykh
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL IL'INYKH SERGEY BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef TANKS_SLOTMAP_H
+#define TANKS_SLOTMAP_H
+
+#include <QVector>
+
+namespace Tanks {
+
+// 低 IndexBits 位為槽位，其餘為代數。0 永遠不是有效的句柄
+typedef quint32 Handle;
+
+/**
+ * @brief The SlotMap class
+ * Maps generational handles to positions in packed arrays. Stores that keep
+ * their entries without holes (EntityStore, BulletPool) move entries around
+ * on removal and report it here, while everybody outside keeps the handle.
+ * A removed handle never resolves again: its slot is reused only with the
+ * next generation.
+ */
+class SlotMap {
+public:
+    enum { IndexBits = 16, IndexMask = (1 << IndexBits) - 1 };
+
+    static inline int slotOf(Handle handle) { return int(handle & IndexMask); }
+
+    Handle insert(int index); // 新句柄指向陣列中的 index
+    void   remove(Handle handle);
+
+    inline int indexOf(Handle handle) const // -1 for a removed handle
+    {
+        int slot = slotOf(handle);
+        if (slot >= _slots.size() || _slots.at(slot).generation != handle >> IndexBits) {
+            return -1;
+        }
+        return _slots.at(slot).index;
+    }
+    inline void setIndex(Handle handle, int index) { _slots[slotOf(handle)].index = index; }
+
+private:
+    struct Slot {
+        int     index      = -1; // 在陣列中的位置，空閒時為 -1
+        quint16 generation = 1;
+    };
+
+    QVector<Slot> _slots;
+    QVector<int>  _freeSlots;
+};
+
+/**
+ * @brief The HandleTable class
+ * Values attached to handles issued by a SlotMap somewhere else, e.g. the
+ * views QMLBridge keeps for tanks and bullets of the game. Lookup is an
+ * array access by slot; a value stored for a removed handle is not found
+ * through a newer handle of the same slot.
+ */
+template <typename T> class HandleTable {
+public:
+    inline T *find(Handle handle)
+    {
+        int slot = SlotMap::slotOf(handle);
+        if (!handle || slot >= _entries.size() || _entries.at(slot).handle != handle) {
+            return nullptr;
+        }
+        return &_entries[slot].value;
+    }
+
+    inline void insert(Handle handle, const T &value)
+    {
+        int slot = SlotMap::slotOf(handle);
+        if (slot >= _entries.size()) {
+            _entries.resize(slot + 1);
+        }
+        _entries[slot].handle = handle;
+        _entries[slot].value  = value;
+    }
+
+    inline void remove(Handle handle)
+    {
+        if (find(handle)) {
+            _entries[SlotMap::slotOf(handle)] = Entry();
+        }
+    }
+
+    inline void clear() { _entries.resize(0); }
+
+private:
+    struct Entry {
+        Handle handle = 0;
+        T      value  = T();
+    };
+
+    QVector<Entry> _entries; // 按槽位
+};
+
+} // namespace Tanks
+
+#endif // TANKS_SLOTMAP_H
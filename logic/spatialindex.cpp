@@ -0,0 +1,188 @@
+#include "spatialindex.h"
+#include "dynamicblock.h"
+
+namespace Tanks {
+
+// SpatialIndex 類的構造函數
+SpatialIndex::SpatialIndex() : _columns(1), _rows(1), _grid(1), _count(0) { }
+
+// SpatialIndex 類的析構函數，仍在索引中的物件不再引用它
+SpatialIndex::~SpatialIndex()
+{
+    for (const Entry &e : _entries) {
+        if (e.block) {
+            e.block->_spatialIndex = nullptr;
+        }
+    }
+}
+
+// 清空索引並重建網格
+void SpatialIndex::reset(const QSize &boardSize)
+{
+    for (const Entry &e : _entries) {
+        if (e.block) {
+            e.block->_spatialIndex = nullptr;
+        }
+    }
+    _entries.resize(0);
+    _freeSlots.resize(0);
+    _count   = 0;
+    _columns = qMax(1, (boardSize.width() >> CellShift) + 1);
+    _rows    = qMax(1, (boardSize.height() >> CellShift) + 1);
+    _grid.resize(_columns * _rows);
+    for (auto &cell : _grid) {
+        cell.resize(0);
+    }
+}
+
+// 把物件加入索引
+void SpatialIndex::insert(DynamicBlock *block, Layer layer)
+{
+    if (block->_spatialIndex) {
+        block->_spatialIndex->remove(block);
+    }
+    int    slot          = allocate();
+    Entry &e             = _entries[slot];
+    e.block              = block;
+    e.cells              = cellsOf(block->geometry());
+    e.layer              = layer;
+    block->_spatialIndex = this;
+    block->_spatialSlot  = slot;
+    link(slot);
+}
+
+// 把物件移出索引
+void SpatialIndex::remove(DynamicBlock *block)
+{
+    if (block->_spatialIndex != this) {
+        return;
+    }
+    int slot = block->_spatialSlot;
+    unlink(slot);
+    _entries[slot]       = Entry();
+    block->_spatialIndex = nullptr;
+    _freeSlots.append(slot);
+    _count--;
+}
+
+// 以矩形和鍵加入一個條目
+int SpatialIndex::insert(const QRect &geometry, Layer layer, quint32 key)
+{
+    int    slot = allocate();
+    Entry &e    = _entries[slot];
+    e.geometry  = geometry;
+    e.cells     = cellsOf(geometry);
+    e.key       = key;
+    e.layer     = layer;
+    link(slot);
+    return slot;
+}
+
+// 移除以矩形登記的條目
+void SpatialIndex::remove(int slot)
+{
+    unlink(slot);
+    _entries[slot] = Entry();
+    _freeSlots.append(slot);
+    _count--;
+}
+
+// 更新以矩形登記的條目
+void SpatialIndex::update(int slot, const QRect &geometry)
+{
+    Entry &e     = _entries[slot];
+    QRect  cells = cellsOf(geometry);
+    e.geometry   = geometry;
+    if (cells != e.cells) {
+        unlink(slot);
+        e.cells = cells;
+        link(slot);
+    }
+}
+
+// 物件移動後更新所在網格
+void SpatialIndex::update(DynamicBlock *block)
+{
+    int   slot  = block->_spatialSlot;
+    QRect cells = cellsOf(block->geometry());
+    if (cells != _entries.at(slot).cells) {
+        unlink(slot);
+        _entries[slot].cells = cells;
+        link(slot);
+    }
+}
+
+// 查找相交的物件
+DynamicBlock *SpatialIndex::find(const QRect &rect, quint8 layers) const
+{
+    int slot = findSlot(rect, layers);
+    return slot < 0 ? nullptr : _entries.at(slot).block;
+}
+
+// 查找相交的條目
+int SpatialIndex::findSlot(const QRect &rect, quint8 layers) const
+{
+    QRect cells = cellsOf(rect);
+    for (int y = cells.top(); y <= cells.bottom(); y++) {
+        for (int x = cells.left(); x <= cells.right(); x++) {
+            for (int slot : _grid.at(y * _columns + x)) {
+                const Entry &e = _entries.at(slot);
+                if ((e.layer & layers) && (e.block ? e.block->geometry() : e.geometry).intersects(rect)) {
+                    return slot;
+                }
+            }
+        }
+    }
+    return -1;
+}
+
+// 分配一個空閒條目
+int SpatialIndex::allocate()
+{
+    int slot;
+    if (_freeSlots.isEmpty()) {
+        slot = _entries.size();
+        _entries.append(Entry());
+    } else {
+        slot = _freeSlots.takeLast();
+    }
+    _count++;
+    return slot;
+}
+
+// 計算矩形佔據的網格範圍，棋盤外的部分歸入邊緣網格
+QRect SpatialIndex::cellsOf(const QRect &geometry) const
+{
+    int l = qBound(0, geometry.left() >> CellShift, _columns - 1);
+    int t = qBound(0, geometry.top() >> CellShift, _rows - 1);
+    int r = qBound(0, geometry.right() >> CellShift, _columns - 1);
+    int b = qBound(0, geometry.bottom() >> CellShift, _rows - 1);
+    return QRect(QPoint(l, t), QPoint(r, b));
+}
+
+// 把條目加入其佔據的網格
+void SpatialIndex::link(int slot)
+{
+    const QRect &cells = _entries.at(slot).cells;
+    for (int y = cells.top(); y <= cells.bottom(); y++) {
+        for (int x = cells.left(); x <= cells.right(); x++) {
+            _grid[y * _columns + x].append(slot);
+        }
+    }
+}
+
+// 把條目從其佔據的網格移除
+void SpatialIndex::unlink(int slot)
+{
+    const QRect &cells = _entries.at(slot).cells;
+    for (int y = cells.top(); y <= cells.bottom(); y++) {
+        for (int x = cells.left(); x <= cells.right(); x++) {
+            QVector<int> &cell = _grid[y * _columns + x];
+            int           i    = cell.indexOf(slot);
+            cell[i]            = cell.last(); // 網格內無序
+            cell.removeLast();
+        }
+    }
+}
+
+} // namespace Tanks
@@ -0,0 +1,102 @@
+/*
+ Copyright (c) 2016, Sergey Ilinykh
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL IL'INYKH SERGEY BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef TANKS_SPATIALINDEX_H
+#define TANKS_SPATIALINDEX_H
+
+#include "basics.h"
+
+#include <QRect>
+#include <QVector>
+
+namespace Tanks {
+
+class DynamicBlock;
+
+/**
+ * @brief The SpatialIndex class
+ * Uniform grid over the board holding tanks and bullets. A block registered
+ * here updates its cells itself on every move and leaves the index when it
+ * is destroyed, so lookups only visit the few cells around the query rect.
+ * Objects that are not blocks (pooled bullets) are registered by rect and
+ * an integer key instead and are moved and removed by their owner.
+ */
+class SpatialIndex {
+public:
+    enum Layer : quint8 { FriendlyTanks = 1, AlienTanks = 2, FriendlyBullets = 4, AlienBullets = 8 };
+
+    static inline Layer tankLayer(Affinity affinity) { return affinity == Friendly ? FriendlyTanks : AlienTanks; }
+    static inline Layer bulletLayer(Affinity affinity) { return affinity == Friendly ? FriendlyBullets : AlienBullets; }
+
+    SpatialIndex();
+    ~SpatialIndex();
+
+    void reset(const QSize &boardSize); // 清空並按棋盤尺寸重建網格
+
+    void insert(DynamicBlock *block, Layer layer);
+    void remove(DynamicBlock *block);
+    void update(DynamicBlock *block); // 物件位置改變後調用
+
+    int            insert(const QRect &geometry, Layer layer, quint32 key); // 返回條目的槽號
+    void           remove(int slot);
+    void           update(int slot, const QRect &geometry);
+    inline quint32 key(int slot) const { return _entries.at(slot).key; }
+
+    inline int count() const { return _count; }
+
+    // 任意一個與 rect 相交且屬於 layers 的物件
+    DynamicBlock *find(const QRect &rect, quint8 layers) const;
+    int           findSlot(const QRect &rect, quint8 layers) const; // 沒有時為 -1
+
+private:
+    enum { CellShift = 3 }; // 8x8 格一個網格，坦克最多跨 4 個
+
+    struct Entry {
+        DynamicBlock *block = nullptr; // 以矩形和鍵登記的條目為空
+        QRect         geometry; // 僅用於以矩形登記的條目
+        QRect         cells; // 佔據的網格範圍
+        quint32       key   = 0;
+        quint8        layer = 0;
+    };
+
+    QRect cellsOf(const QRect &geometry) const;
+    int   allocate();
+    void  link(int slot);
+    void  unlink(int slot);
+
+    int                   _columns;
+    int                   _rows;
+    QVector<QVector<int>> _grid; // 每個網格中的條目序號
+    QVector<Entry>        _entries;
+    QVector<int>          _freeSlots;
+    int                   _count;
+};
+
+} // namespace Tanks
+
+#endif // TANKS_SPATIALINDEX_H
@@ -3,28 +3,29 @@
 namespace Tanks {
 
 // 坦克類的構造函數，設置坦克的初始屬性
-Tank::Tank(Affinity affinity, quint8 variant) : _affinity(affinity), _variant(variant), _shootTicks(0)
+Tank::Tank(EntityStore *store, Affinity affinity, quint8 variant) :
+    DynamicBlock(store), _affinity(affinity), _variant(variant)
 {
     setTankDefaults();
-    _geometry.setWidth(4); // 在棋盤座標中設置寬度為 4
-    _geometry.setHeight(4); // 在棋盤座標中設置高度為 4
+    _store->geometry(index()).setSize(size()); // 在棋盤座標中為 4x4
 }
 
 // 設置坦克的預設屬性
 void Tank::setTankDefaults()
 {
-    _armorLevel = 1; // 初始裝甲等級
+    quint8 &armor = _store->armor(index());
+    armor         = 1; // 初始裝甲等級
     if (_affinity == Friendly) {
-        _armorLevel = 1;
+        armor = 1;
         if (_variant == BurstFireTank) { // 快速射擊坦克
             _bulletCount = 2; // 彈藥數量
         }
     } else {
         if (_variant == SpeedyTank) { // 高速坦克
-            _speed = 2; // 設置速度
+            setSpeed(2); // 設置速度
         }
         if (_variant == ArmoredTank) { // 裝甲坦克
-            _armorLevel = 4; // 裝甲等級
+            armor = 4; // 裝甲等級
         }
     }
 }
@@ -32,14 +33,14 @@ void Tank::setTankDefaults()
 // 坦克射擊功能
 void Tank::fire()
 {
-    // 創建新的子彈實例
-    auto b = new Bullet(_affinity, isArmorPiercing() ? Bullet::ArmorPiercing : Bullet::Regular);
-    b->setSpeed(_affinity == Alien && _variant == FastBulletTank ? 3 : 2); // 設置子彈速度
+    // 描述新的子彈，Game 收到 fired() 後把它放入子彈池
+    Bullet b(_affinity, isArmorPiercing() ? Bullet::ArmorPiercing : Bullet::Regular);
+    b.speed = _affinity == Alien && _variant == FastBulletTank ? 3 : 2; // 設置子彈速度
 
-    QRect fmr = QRect(0, 0, 2, 2);
-    fmr.moveCenter(_geometry.center());
+    QRect fmr = QRect(QPoint(0, 0), Bullet::size());
+    fmr.moveCenter(geometry().center());
     int dx = 0, dy = 0;
-    switch (_direction) {
+    switch (direction()) {
     case North:
         dy = -1;
         break;
@@ -55,11 +56,11 @@ void Tank::fire()
     }
     fmr.translate(dx, dy);
 
-    b->setInitialPosition(fmr.topLeft());
-    b->setDirection(_direction);
+    b.position  = fmr.topLeft();
+    b.direction = direction();
     resetShootClock();
 
-    _bullet = QSharedPointer<Bullet>(b);
+    _bullet = b;
 
     emit fired(); // 發射信號
 }
@@ -67,35 +68,39 @@ void Tank::fire()
 // 重置射擊時鐘（用於控制射擊頻率）
 void Tank::resetShootClock()
 {
-    _shootTicks = 10; // 預設值
+    quint16 &cooldown = _store->cooldown(index());
+    cooldown          = 10; // 預設值
     if (_affinity == Friendly && _variant == BurstFireTank) {
-        _shootTicks = 5; // 快速射擊坦克的特殊處理
+        cooldown = 5; // 快速射擊坦克的特殊處理
     }
 }
 
 // 處理坦克離開棋盤的行為
 DynamicBlock::OutBoardAction Tank::outBoardAction() const { return DynamicBlock::StopMove; }
 
-// 時鐘滴答函數，用於更新坦克狀態
-void Tank::clockTick()
+// 生成坦克事件的函數
+GameEvent Tank::makeEvent(GameEvent::Type type) const
 {
-    if (_shootTicks) {
-        _shootTicks--;
-    }
-    DynamicBlock::clockTick();
+    GameEvent e = DynamicBlock::makeEvent(type);
+    e.affinity  = _affinity;
+    return e;
 }
 
 // 處理坦克被子彈擊中的情況
 void Tank::catchBullet()
 {
-    if (!_armorLevel) {
+    quint8 &armor = _store->armor(index());
+    if (!armor) {
         qDebug("Something went wrong"); // 錯誤處理
         return;
     }
-    _armorLevel--;
-    if (_armorLevel) {
+    armor--;
+    if (armor) {
+        postEvent(GameEvent::TankArmorChanged, armor);
         emit armourChanged(); // 裝甲等級改變的信號
     } else {
+        leaveSpatialIndex();
+        postEvent(GameEvent::TankDestroyed);
         emit tankDestroyed(); // 坦克被摧毀的信號
     }
 }
@@ -103,7 +108,7 @@ void Tank::catchBullet()
 // 自我摧毀功能
 void Tank::selfDestroy()
 {
-    _armorLevel = 1;
+    _store->armor(index()) = 1;
     catchBullet();
 }
 
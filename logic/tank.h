@@ -29,17 +29,20 @@ public:
     };
 
            // Tank 類的構造函數
-    Tank(Affinity affinity, quint8 variant = 0);
+    Tank(EntityStore *store, Affinity affinity, quint8 variant = 0);
 
            // 獲取坦克的親和性和變體
     inline Affinity affinity() const { return _affinity; }
     inline quint8   variant() const { return _variant; }
 
+           // 坦克在棋盤座標中的尺寸
+    static inline QSize size() { return QSize(4, 4); }
+
            // 設置坦克的預設值
     void setTankDefaults();
 
            // 檢查坦克是否能夠射擊
-    inline bool canShoot() const { return _shootTicks == 0; }
+    inline bool canShoot() const { return _store->cooldown(index()) == 0; }
 
            // 判斷是否為穿甲彈
     bool isArmorPiercing() const { return (_affinity == Friendly) && (_variant == ArmorPiercingTank); }
@@ -53,8 +56,8 @@ public:
            // 處理坦克離開遊戲範圍的行動
     OutBoardAction outBoardAction() const;
 
-           // 時間流逝的處理函數
-    void clockTick();
+           // 坦克事件還帶有親和性
+    GameEvent makeEvent(GameEvent::Type type) const;
 
            // 坦克被子彈擊中的處理函數
     void catchBullet();
@@ -62,16 +65,8 @@ public:
            // 自我摧毀的函數
     void selfDestroy();
 
-           // 獲取射擊後的子彈
-    QSharedPointer<Bullet> takeBullet()
-    {
-        QSharedPointer<Bullet> ret;
-        _bullet.swap(ret);
-        return ret;
-    }
-
-           // 獲取當前的子彈
-    QSharedPointer<Bullet> bullet() const { return _bullet; }
+           // 獲取最近一次射擊的子彈
+    const Bullet &bullet() const { return _bullet; }
 
 signals:
     // 坦克被摧毀的訊號
@@ -84,12 +79,10 @@ signals:
     void fired();
 
 private:
-    Affinity               _affinity; // 坦克的親和性
-    quint8                 _variant; // 坦克的變體
-    quint8                 _armorLevel; // 裝甲等級
-    quint8                 _bulletCount; // 子彈數量
-    int                    _shootTicks; // 射擊計時器
-    QSharedPointer<Bullet> _bullet; // 存儲坦克射擊的子彈
+    Affinity _affinity; // 坦克的親和性
+    quint8   _variant; // 坦克的變體
+    quint8   _bulletCount; // 子彈數量
+    Bullet   _bullet; // 最近一次射擊的子彈，由 Game 放入子彈池
 };
 
 } // namespace Tanks
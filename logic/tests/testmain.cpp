@@ -0,0 +1,21 @@
+#include "tst_board.h"
+#include "tst_humanplayer.h"
+
+#include <QCoreApplication>
+#include <QtTest>
+
+// 依次執行所有測試類，有失敗時返回非零
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int              failed = 0;
+    {
+        TestBoard test;
+        failed += QTest::qExec(&test, argc, argv);
+    }
+    {
+        TestHumanPlayer test;
+        failed += QTest::qExec(&test, argc, argv);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,168 @@
+#include "abstractmaploader.h"
+#include "board.h"
+#include "chunkedmap.h"
+#include "tst_board.h"
+
+#include <QtTest>
+
+using namespace Tanks;
+
+namespace {
+
+// 固定地圖：一塊磚牆，可選擇按區域加載。尺寸以地圖塊為單位，棋盤上放大兩倍
+class BrickMapLoader : public AbstractMapLoader {
+public:
+    BrickMapLoader(const QSize &size, bool regions) : _size(size), _regions(regions), _pending(false) { }
+
+    bool open()
+    {
+        _pending = !_regions;
+        return true;
+    }
+    QSize     dimensions() const { return _size; }
+    bool      hasNext() const { return _pending; }
+    MapObject next()
+    {
+        _pending = false;
+        return brick();
+    }
+    QList<quint8> enemyTanks() const { return QList<quint8>() << 0; }
+    QList<QPoint> enemyStartPositions() const { return QList<QPoint>() << QPoint(0, 0); }
+    QList<QPoint> friendlyStartPositions() const { return QList<QPoint>() << QPoint(0, _size.height() - 2); }
+    QPoint        flagPosition() const { return QPoint(4, _size.height() - 2); }
+    bool          supportsRegions() const { return _regions; }
+
+    QList<MapObject> loadRegion(const QRect &region)
+    {
+        QList<MapObject> objects;
+        MapObject        b = brick();
+        b.geometry &= region;
+        if (!b.geometry.isEmpty()) {
+            objects.append(b);
+        }
+        return objects;
+    }
+
+    // 磚牆在棋盤上是 (80, 80) 起的 8x8，位於第 (1, 1) 個區塊
+    static MapObject brick()
+    {
+        MapObject b;
+        b.geometry = QRect(40, 40, 4, 4);
+        b.type     = Brick;
+        return b;
+    }
+
+private:
+    QSize _size;
+    bool  _regions;
+    bool  _pending;
+};
+
+const QPoint brickCell(80, 80);
+const QRect  brickChunk(64, 64, 64, 64);
+
+// 按 (y, x) 排序，方便比較髒區域
+bool rectLess(const QRect &a, const QRect &b) { return qMakePair(a.y(), a.x()) < qMakePair(b.y(), b.x()); }
+
+} // namespace
+
+// 寫入後恢復快照，地形回到拍攝快照時的樣子
+void TestBoard::restoreUndoesWrites()
+{
+    BrickMapLoader loader(QSize(64, 64), false);
+    Board          board;
+    QVERIFY(board.loadMap(&loader));
+
+    Board::Snapshot snapshot = board.snapshot();
+    QCOMPARE(snapshot.version(), board.version());
+    board.renderBlock(Nothing, QRect(brickCell, QSize(4, 4)));
+    board.renderBlock(Water, QRect(8, 8, 4, 4));
+    QCOMPARE(board.blockType(brickCell), Nothing);
+    QCOMPARE(board.blockType(QPoint(8, 8)), Water);
+
+    QVERIFY(board.restore(snapshot));
+    QCOMPARE(board.blockType(brickCell), Brick);
+    QCOMPARE(board.blockType(QPoint(8, 8)), Nothing);
+    QCOMPARE(board.blockType(brickCell + QPoint(7, 7)), Brick);
+}
+
+// 恢復時只有內容不同的區塊記為髒區域，版本繼續遞增
+void TestBoard::restoreReportsChangedChunks()
+{
+    BrickMapLoader loader(QSize(64, 64), false);
+    Board          board;
+    QVERIFY(board.loadMap(&loader));
+
+    Board::Snapshot snapshot = board.snapshot();
+    quint64         before   = board.version();
+    QVERIFY(board.restore(snapshot)); // nothing changed since the snapshot
+    QCOMPARE(board.version(), before);
+
+    board.renderBlock(Nothing, QRect(brickCell, QSize(2, 2)));
+    board.renderBlock(Water, QRect(8, 8, 2, 2));
+    quint64 written = board.version();
+    QVERIFY(board.restore(snapshot));
+    QVERIFY(board.version() > written);
+
+    QVector<QRect> regions;
+    QVERIFY(board.dirtyRegions(written, regions));
+    std::sort(regions.begin(), regions.end(), rectLess);
+    QCOMPARE(regions.count(), 2);
+    QCOMPARE(regions.at(0), QRect(0, 0, 64, 64));
+    QCOMPARE(regions.at(1), brickChunk);
+}
+
+// 快照只能恢復到拍攝它的那張地圖
+void TestBoard::restoreRejectsOtherMap()
+{
+    BrickMapLoader loader(QSize(64, 64), false);
+    Board          board;
+    QVERIFY(!board.restore(Board::Snapshot()));
+    QVERIFY(board.loadMap(&loader));
+
+    Board::Snapshot snapshot = board.snapshot();
+    QVERIFY(board.loadMap(&loader));
+    board.renderBlock(Nothing, QRect(brickCell, QSize(4, 4)));
+    quint64 version = board.version();
+    QVERIFY(!board.restore(snapshot));
+    QCOMPARE(board.version(), version);
+    QCOMPARE(board.blockType(brickCell), Nothing);
+}
+
+// 分頁棋盤：快照之後才加載並修改的區塊恢復後重新從加載器讀取，其他區塊照常卸下
+void TestBoard::restorePagedBoard()
+{
+    const qint64   oneChunk = ChunkedMap::worstCaseBytes(QSize(ChunkedMap::ChunkSize, ChunkedMap::ChunkSize));
+    BrickMapLoader loader(QSize(256, 256), true);
+    Board          board;
+    board.setMemoryBudget(oneChunk * 8);
+    QVERIFY(board.loadMap(&loader));
+    QVERIFY(board.isPaged());
+
+    Board::Snapshot snapshot = board.snapshot();
+    QCOMPARE(board.blockType(brickCell), Brick); // pages the chunk in
+    board.renderBlock(Nothing, QRect(brickCell, QSize(8, 8)));
+    QCOMPARE(board.blockType(brickCell), Nothing);
+
+    // read the whole board; clean chunks are evicted, the modified one stays
+    for (int y = 0; y < board.size().height(); y += ChunkedMap::ChunkSize) {
+        for (int x = 0; x < board.size().width(); x += ChunkedMap::ChunkSize) {
+            board.blockType(QPoint(x, y));
+        }
+    }
+    QVERIFY(board.storageBytes() <= oneChunk * 12);
+    QCOMPARE(board.blockType(brickCell), Nothing);
+
+    quint64 written = board.version();
+    QVERIFY(board.restore(snapshot));
+    QVector<QRect> regions;
+    QVERIFY(board.dirtyRegions(written, regions));
+    bool covered = false; // chunks paged in since the snapshot are reported too, possibly merged
+    foreach (const QRect &r, regions) {
+        covered |= r.contains(brickChunk);
+    }
+    QVERIFY(covered);
+    QCOMPARE(board.blockType(brickCell), Brick);
+    QCOMPARE(board.blockType(brickCell + QPoint(7, 7)), Brick);
+    QCOMPARE(board.blockType(brickCell + QPoint(8, 8)), Nothing);
+}
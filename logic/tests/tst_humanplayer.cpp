@@ -0,0 +1,84 @@
+#include "abstractmaploader.h"
+#include "board.h"
+#include "bullet.h"
+#include "entitystore.h"
+#include "game.h"
+#include "gameevents.h"
+#include "tank.h"
+#include "tst_humanplayer.h"
+
+#include <QtTest>
+
+using namespace Tanks;
+
+namespace {
+
+// 沒有任何地形的小地圖，只有一輛敵方坦克
+class EmptyMapLoader : public AbstractMapLoader {
+public:
+    bool          open() { return true; }
+    QSize         dimensions() const { return QSize(13, 13); }
+    bool          hasNext() const { return false; }
+    MapObject     next() { return MapObject(); }
+    QList<quint8> enemyTanks() const { return QList<quint8>() << 0; }
+    QList<QPoint> enemyStartPositions() const { return QList<QPoint>() << QPoint(0, 0); }
+    QList<QPoint> friendlyStartPositions() const { return QList<QPoint>() << QPoint(2, 11); }
+    QPoint        flagPosition() const { return QPoint(6, 11); }
+};
+
+// 統計 cursor 之後友方坦克出場的次數
+int friendlySpawns(const Game &game, quint64 &cursor)
+{
+    QVector<GameEvent> events;
+    game.events()->read(cursor, events);
+    int spawns = 0;
+    foreach (const GameEvent &e, events) {
+        if (e.type == GameEvent::TankSpawned && e.affinity == Friendly) {
+            spawns++;
+        }
+    }
+    return spawns;
+}
+
+} // namespace
+
+// 玩家坦克在起始位置被佔據時陣亡：等位置空出後只出場一次，也不會再扣命
+void TestHumanPlayer::respawnWaitsForFreeSpawn()
+{
+    Game game;
+    game.setManualClock(true);
+    game.setMapLoader(new EmptyMapLoader);
+    game.start(1);
+    game.step(0);
+    QCOMPARE(game.entities()->count(), 1);
+
+    // 擋住敵方出生點，場上只留玩家坦克
+    EntityStore blockers;
+    Tank        enemyBlocker(&blockers, Alien);
+    enemyBlocker.setInitialPosition(game.board()->enemyStartPositions().first());
+    game.board()->addOccupant(&enemyBlocker);
+
+    // 佔據玩家的起始位置，再讓敵方子彈擊中玩家坦克
+    QPoint spawn = game.board()->friendlyStartPositions().first();
+    Tank   spawnBlocker(&blockers, Alien);
+    spawnBlocker.setInitialPosition(spawn);
+    game.board()->addOccupant(&spawnBlocker);
+
+    quint64 cursor = game.events()->head();
+    Bullet  bullet(Alien);
+    bullet.position = spawn + QPoint(1, 1);
+    game.addBullet(bullet);
+
+    QCOMPARE(game.step(5), 5);
+    QCOMPARE(game.playerLifes(0), 2);
+    QCOMPARE(game.entities()->count(), 0); // the destroyed tank is gone while the respawn waits
+    QCOMPARE(friendlySpawns(game, cursor), 0);
+
+    game.board()->removeOccupant(&spawnBlocker);
+    QCOMPARE(game.step(5), 5);
+    QCOMPARE(friendlySpawns(game, cursor), 1);
+    QCOMPARE(game.playerLifes(0), 2);
+    QCOMPARE(game.entities()->count(), 1);
+
+    game.board()->removeOccupant(&enemyBlocker);
+}
@@ -0,0 +1,118 @@
+#include "tickprofiler.h"
+
+#include <algorithm>
+
+namespace Tanks {
+
+// TickProfiler 類的構造函數
+TickProfiler::TickProfiler(int window) : _enabled(true), _budgetNs(50 * 1000000)
+{
+    for (int i = 0; i < PhasesCount; i++) {
+        _rings[i].samples.resize(qMax(1, window));
+        _current[i] = 0;
+        _last[i]    = 0;
+    }
+}
+
+// 開始一個週期的計時
+void TickProfiler::beginTick()
+{
+    if (!_enabled) {
+        return;
+    }
+    for (int i = 0; i < PhasesCount; i++) {
+        if (i != MapLoadPhase) {
+            _current[i] = 0;
+        }
+    }
+    _tickTimer.start();
+}
+
+// 結束一個週期，把各階段耗時放入樣本環
+qint64 TickProfiler::endTick()
+{
+    if (!_enabled) {
+        return 0;
+    }
+    _current[TickPhase] = _tickTimer.nsecsElapsed();
+    for (int i = 0; i < PhasesCount; i++) {
+        if (i != MapLoadPhase) {
+            record(Phase(i), _current[i]);
+        }
+    }
+    return _last[TickPhase];
+}
+
+// 上一個週期是否超出預算
+bool TickProfiler::isOverrun() const { return _enabled && _last[TickPhase] > _budgetNs; }
+
+// 記錄一個樣本
+void TickProfiler::record(Phase phase, qint64 ns)
+{
+    Ring &ring             = _rings[phase];
+    ring.samples[ring.pos] = ns;
+    ring.pos               = (ring.pos + 1) % ring.samples.size();
+    ring.count             = qMin(ring.count + 1, int(ring.samples.size()));
+    _last[phase]           = ns;
+}
+
+// 計算一個階段的統計值
+TickProfiler::Stats TickProfiler::stats(Phase phase) const
+{
+    const Ring &ring = _rings[phase];
+    Stats       s;
+    s.samples = ring.count;
+    if (!ring.count) {
+        return s;
+    }
+    QVector<qint64> sorted(ring.samples.begin(), ring.samples.begin() + ring.count);
+    std::sort(sorted.begin(), sorted.end());
+    s.p50Ns = sorted[(ring.count - 1) / 2];
+    s.p99Ns = sorted[(ring.count - 1) * 99 / 100];
+    s.maxNs = sorted.last();
+    return s;
+}
+
+// 上一個週期各階段耗時的摘要（用於超時警告）
+QString TickProfiler::lastTickReport() const
+{
+    QString ret;
+    for (int i = 0; i < PhasesCount; i++) {
+        if (i != MapLoadPhase) {
+            ret += QString::asprintf("%s%s=%.3fms", ret.isEmpty() ? "" : " ", phaseName(Phase(i)), _last[i] / 1e6);
+        }
+    }
+    return ret;
+}
+
+// 所有階段的統計報告，每個階段一行
+QString TickProfiler::report() const
+{
+    QString ret = QString::asprintf("%-8s %9s %9s %9s\n", "phase", "p50 ms", "p99 ms", "max ms");
+    for (int i = 0; i < PhasesCount; i++) {
+        Stats s = stats(Phase(i));
+        ret += QString::asprintf(
+            "%-8s %9.3f %9.3f %9.3f\n", phaseName(Phase(i)), s.p50Ns / 1e6, s.p99Ns / 1e6, s.maxNs / 1e6);
+    }
+    return ret;
+}
+
+// 清空所有樣本
+void TickProfiler::reset()
+{
+    for (int i = 0; i < PhasesCount; i++) {
+        _rings[i].pos   = 0;
+        _rings[i].count = 0;
+        _current[i]     = 0;
+        _last[i]        = 0;
+    }
+}
+
+// 階段名稱
+const char *TickProfiler::phaseName(Phase phase)
+{
+    static const char *names[PhasesCount] = { "tick", "humans", "ai", "bullets", "bridge", "mapload" };
+    return names[phase];
+}
+
+} // namespace Tanks
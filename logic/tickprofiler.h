@@ -0,0 +1,118 @@
+/*
+ Copyright (c) 2016, Sergey Ilinykh
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL IL'INYKH SERGEY BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef TANKS_TICKPROFILER_H
+#define TANKS_TICKPROFILER_H
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+
+namespace Tanks {
+
+/**
+ * @brief The TickProfiler class
+ * Measures how long each phase of a game tick takes with the monotonic
+ * clock and keeps the last samples of every phase in a ring to report
+ * p50/p99/max. Phases timed inside another phase (bridge fan-out happens
+ * while players move) are included in the outer phase as well.
+ */
+class TickProfiler {
+public:
+    enum Phase { TickPhase, HumansPhase, AIPhase, BulletsPhase, BridgePhase, MapLoadPhase, PhasesCount };
+
+    struct Stats {
+        qint64 p50Ns   = 0;
+        qint64 p99Ns   = 0;
+        qint64 maxNs   = 0;
+        int    samples = 0;
+    };
+
+    // 累計一個階段在本週期內的耗時
+    class Scope {
+    public:
+        inline Scope(TickProfiler *profiler, Phase phase) : _profiler(profiler), _phase(phase)
+        {
+            if (_profiler->_enabled) {
+                _timer.start();
+            }
+        }
+        inline ~Scope()
+        {
+            if (_profiler->_enabled) {
+                _profiler->add(_phase, _timer.nsecsElapsed());
+            }
+        }
+
+    private:
+        TickProfiler *_profiler;
+        Phase         _phase;
+        QElapsedTimer _timer;
+    };
+
+    explicit TickProfiler(int window = 256);
+
+    inline void setEnabled(bool enabled) { _enabled = enabled; }
+    inline bool isEnabled() const { return _enabled; }
+
+    inline void   setBudgetNs(qint64 ns) { _budgetNs = ns; }
+    inline qint64 budgetNs() const { return _budgetNs; }
+
+    void   beginTick();
+    qint64 endTick(); // 返回本週期總耗時，未啟用時返回 0
+    bool   isOverrun() const;
+
+    inline void add(Phase phase, qint64 ns) { _current[phase] += ns; }
+    void        record(Phase phase, qint64 ns);
+
+    Stats   stats(Phase phase) const;
+    qint64  lastNs(Phase phase) const { return _last[phase]; }
+    QString lastTickReport() const;
+    QString report() const;
+    void    reset();
+
+    static const char *phaseName(Phase phase);
+
+private:
+    struct Ring {
+        QVector<qint64> samples;
+        int             pos   = 0;
+        int             count = 0;
+    };
+
+    bool          _enabled;
+    qint64        _budgetNs;
+    QElapsedTimer _tickTimer;
+    qint64        _current[PhasesCount];
+    qint64        _last[PhasesCount];
+    Ring          _rings[PhasesCount];
+};
+
+} // namespace Tanks
+
+#endif // TANKS_TICKPROFILER_H
@@ -0,0 +1,137 @@
+#include "tickscheduler.h"
+
+#include <QTimer>
+
+namespace Tanks {
+
+// TickScheduler 類的構造函數，預設 20 Hz
+TickScheduler::TickScheduler(QObject *parent) :
+    QObject(parent), _timer(new QTimer(this)), _driver(TimerDriver), _active(false), _endBatch(false),
+    _maxCatchUp(5), _timeScale(1.0), _maxBatchNs(12 * 1000000), _intervalNs(50 * 1000000), _lastNs(0), _accumulator(0),
+    _dropped(0)
+{
+    _timer->setSingleShot(true);
+    _timer->setTimerType(Qt::PreciseTimer);
+    connect(_timer, &QTimer::timeout, this, &TickScheduler::advance);
+}
+
+// 設置每秒週期數的函數
+void TickScheduler::setTickRate(double hz)
+{
+    qint64 interval = qint64(1e9 / qBound(1.0, hz, 1000.0));
+    if (interval == _intervalNs) {
+        return;
+    }
+    _intervalNs  = interval;
+    _accumulator = qMin(_accumulator, _intervalNs - 1);
+    if (_active && _driver == TimerDriver) {
+        armTimer();
+    }
+    emit tickRateChanged();
+}
+
+// 獲取每秒週期數的函數
+double TickScheduler::tickRate() const { return 1e9 / _intervalNs; }
+
+// 設置時間倍率的函數，<= 0 表示盡可能快
+void TickScheduler::setTimeScale(double scale)
+{
+    scale = scale > 0 ? qMin(scale, 1000.0) : 0;
+    if (scale == _timeScale) {
+        return;
+    }
+    _timeScale = scale;
+    if (_active && _driver == TimerDriver) {
+        armTimer();
+    }
+    emit timeScaleChanged();
+}
+
+// 切換驅動方式的函數
+void TickScheduler::setDriver(Driver driver)
+{
+    _driver = driver;
+    if (!_active) {
+        return;
+    }
+    if (_driver == TimerDriver) {
+        armTimer();
+    } else {
+        _timer->stop();
+    }
+}
+
+// 開始計時，第一個週期在一個間隔之後
+void TickScheduler::start()
+{
+    _clock.start();
+    _lastNs      = 0;
+    _accumulator = 0;
+    _active      = true;
+    if (_driver == TimerDriver) {
+        armTimer();
+    }
+}
+
+// 停止計時的函數
+void TickScheduler::stop()
+{
+    _active = false;
+    _timer->stop();
+}
+
+// 把流逝的時間換算成週期並執行
+void TickScheduler::advance()
+{
+    if (!_active) {
+        return;
+    }
+    qint64 now   = _clock.nsecsElapsed();
+    int    ticks = 0;
+    _endBatch    = false;
+    if (isUnlimited()) {
+        _accumulator = 0;
+        do { // 至少一個週期，直到用完本批的時間預算
+            ticks++;
+            emit tick();
+        } while (_active && !_endBatch && _clock.nsecsElapsed() - now < _maxBatchNs);
+        _lastNs = _clock.nsecsElapsed();
+    } else {
+        _accumulator += qint64((now - _lastNs) * _timeScale);
+        _lastNs = now;
+
+        // 加速時同一段牆鐘時間內允許的週期數按倍率放大
+        int maxTicks = qMax(_maxCatchUp, int(_maxCatchUp * _timeScale));
+        while (_accumulator >= _intervalNs && ticks < maxTicks && _active && !_endBatch) {
+            _accumulator -= _intervalNs;
+            ticks++;
+            emit tick();
+        }
+        if (!_endBatch && _accumulator >= _intervalNs) { // 追不上了，丟棄積壓的週期
+            _dropped += quint64(_accumulator / _intervalNs);
+            _accumulator %= _intervalNs;
+        }
+    }
+    if (!_active) {
+        return; // 週期內停止了時鐘（例如重新開始遊戲）
+    }
+    if (ticks) {
+        emit advanced(ticks);
+    }
+    if (_driver == TimerDriver) {
+        armTimer();
+    }
+}
+
+// 在下一個週期的截止時間觸發計時器
+void TickScheduler::armTimer()
+{
+    if (isUnlimited()) {
+        _timer->start(0); // 讓事件循環處理輸入後立即繼續
+        return;
+    }
+    qint64 remainNs = qint64((_intervalNs - _accumulator) / _timeScale) - (_clock.nsecsElapsed() - _lastNs);
+    _timer->start(int(qMax(qint64(0), (remainNs + 999999) / 1000000)));
+}
+
+} // namespace Tanks
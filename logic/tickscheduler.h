@@ -0,0 +1,121 @@
+/*
+ Copyright (c) 2016, Sergey Ilinykh
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL IL'INYKH SERGEY BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef TANKS_TICKSCHEDULER_H
+#define TANKS_TICKSCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+
+class QTimer;
+
+namespace Tanks {
+
+/**
+ * @brief The TickScheduler class
+ * Fixed-timestep clock. Elapsed wall time is collected in an accumulator
+ * and paid out as whole ticks, so a stall is caught up instead of slowing
+ * the game down. At most maxCatchUpTicks() run per advance(); any backlog
+ * beyond that is dropped to avoid a spiral of death.
+ *
+ * With TimerDriver a precise single-shot timer is re-armed for the next
+ * tick deadline. With ExternalDriver the owner calls advance(), e.g. on
+ * every QQuickWindow::afterAnimating, so ticks line up with frames.
+ *
+ * The time scale multiplies the game time paid out per wall time. A scale
+ * <= 0 runs as many ticks as fit into maxBatchNs() per advance().
+ * advanced() is emitted once after every batch of ticks so observers can
+ * publish only the final state of the batch. A tick may call endBatch() to
+ * close the batch early; the remaining time is kept for the next advance().
+ */
+class TickScheduler : public QObject {
+    Q_OBJECT
+public:
+    enum Driver { TimerDriver, ExternalDriver };
+
+    explicit TickScheduler(QObject *parent = 0);
+
+    void          setTickRate(double hz);
+    double        tickRate() const;
+    inline qint64 tickIntervalNs() const { return _intervalNs; }
+
+    inline void setMaxCatchUpTicks(int ticks) { _maxCatchUp = qMax(1, ticks); }
+    inline int  maxCatchUpTicks() const { return _maxCatchUp; }
+
+    void          setTimeScale(double scale);
+    inline double timeScale() const { return _timeScale; }
+    inline bool   isUnlimited() const { return _timeScale <= 0; }
+
+    // 無上限模式下每次 advance() 可用的牆鐘時間
+    inline void   setMaxBatchNs(qint64 ns) { _maxBatchNs = qMax(qint64(1), ns); }
+    inline qint64 maxBatchNs() const { return _maxBatchNs; }
+
+    // 在目前的週期之後結束本批，剩下的週期留給下一次 advance()
+    inline void endBatch() { _endBatch = true; }
+
+    void          setDriver(Driver driver);
+    inline Driver driver() const { return _driver; }
+
+    void        start();
+    void        stop();
+    inline bool isActive() const { return _active; }
+
+    // 追趕上限之外被丟棄的週期數
+    inline quint64 droppedTicks() const { return _dropped; }
+    // 距離下一個週期的進度 [0, 1)，可用於渲染插值
+    inline double alpha() const { return double(_accumulator) / _intervalNs; }
+
+signals:
+    void tick();
+    void advanced(int ticks);
+    void tickRateChanged();
+    void timeScaleChanged();
+
+public slots:
+    void advance();
+
+private:
+    void armTimer();
+
+    QTimer       *_timer;
+    QElapsedTimer _clock;
+    Driver        _driver;
+    bool          _active;
+    bool          _endBatch; // 本批已被提前結束
+    int           _maxCatchUp;
+    double        _timeScale;
+    qint64        _maxBatchNs;
+    qint64        _intervalNs;
+    qint64        _lastNs;
+    qint64        _accumulator;
+    quint64       _dropped;
+};
+
+} // namespace Tanks
+
+#endif // TANKS_TICKSCHEDULER_H
@@ -26,6 +26,7 @@
 */
 
 import QtQuick 2.6
+import QtQuick.Window 2.2
 import QtMultimedia
 import com.rsoft.tanks 1.0
 
@@ -47,6 +48,7 @@ Row {
 
         Tanks {
             id: game
+            frameDriver: battleField.Window.window
 
             /* see basics.h
             North = 0
@@ -59,40 +61,9 @@ Row {
             property var p1keys: [Qt.Key_W, Qt.Key_S, Qt.Key_A, Qt.Key_D, Qt.Key_Space]
             property var p2keys: [Qt.Key_Up, Qt.Key_Down, Qt.Key_Left, Qt.Key_Right, Qt.Key_Shift]
 
-            property var tanksList: []
-            property var bulletsList: []
-            property var tanksMap: ({})
-            property var bulletsMap: ({})
             property var pendingBlockRemove: []
 
-            function bigExplosion(x, y, width, height, id) {
-                var source = 'import QtQuick 2.0; AnimatedSprite { id:explode; z:200; source: "img/explosion1"; frameHeight: 16; frameWidth: 16; frameRate:6; frameCount:3; '+
-                        'x:'+ x + "; y:" + y + '; width:' + width + '; height:' + height +
-                        ';ParallelAnimation { running: true; ' +
-                        'NumberAnimation { target:explode; property:"x"; to: '+(x-width)+'; duration: 500; }\n' +
-                        'NumberAnimation { target:explode; property:"y"; to: '+(y-width)+'; duration: 500; }\n' +
-                        'NumberAnimation { target:explode; property:"width"; to: '+(3*width)+'; duration: 500; }\n' +
-                        'NumberAnimation { target:explode; property:"height"; to: '+(3*height)+'; duration: 500; }\n' +
-                        '} }'
-                var obj = Qt.createQmlObject(source, battleField, "bigExplosion_" + id);
-                obj.destroy(500)
-            }
-
-            onMapRendered: {
-                console.log("C++ map rendered");
-                // destroy previous objects
-                for (var i=0; i < game.tanksList.length; i++) {
-                    game.tanksList[i].destroy();
-                }
-                game.tanksList = [];
-                game.tanksMap = {};
-
-                for (let i=0; i < game.bulletsList.length; i++) {
-                    game.bulletsList[i].destroy();
-                }
-                game.bulletsList = [];
-                game.bulletsMap = {};
-
+            function reloadTerrain() {
                 game.pendingBlockRemove = []
                 lowerLayer.lowerRendered = false
                 lowerLayer.lowerMapImage = "image://mapprovider/" + game.bridgeId + "/map"
@@ -104,6 +75,11 @@ Row {
                 lowerLayer.loadImage(lowerLayer.lowerMapImage)
                 bushLayer.source = ""
                 bushLayer.source = "image://mapprovider/" + game.bridgeId + "/bush"
+            }
+
+            onMapRendered: {
+                console.log("C++ map rendered");
+                reloadTerrain()
 
                 var g = game.flagGeometry
                 flag.x = g.x
@@ -114,110 +90,106 @@ Row {
 
             }
 
-            onFlagChanged: {
-                flag.source = game.flagFile;
-                bigExplosion(flag.x, flag.y, flag.width, flag.height)
-            }
-
-            onNewTank: function(tank) {
-
-                var source = 'import QtQuick 2.0; Image {\n' +
-                        'id:' + tank.id + '\n' +
-                        'property int animFrame: 0\n' +
-                        'property int tankLevel: ' + tank.variant + '\n' +
-                        'source: "image://tankprovider/' + tank.affinity + '/' + tank.variant + '/' + tank.direction + '/0"\n' +
-                        'width: ' + tank.geometry.width + '\n' +
-                        'height: ' + tank.geometry.height + '\n' +
-                        'smooth: false\n' +
-                        'x: ' + tank.geometry.x + '\n' +
-                        'y: ' + tank.geometry.y + '\n' +
-                        'Behavior on x { NumberAnimation { duration:150 } }\n' +
-                        'Behavior on y { NumberAnimation { duration:150 } }\n' +
-                        'z:50 }';
-                //console.log("New tank! " + source)
-                var obj = Qt.createQmlObject(source, battleField, "dynamicTank_" + tank.id);
-                game.tanksMap[tank.id] = obj;
-                game.tanksList.push(obj)
+            // terrain history was lost, tanks and bullets stay where they are
+            onTerrainRendered: {
+                reloadTerrain()
             }
 
-            onNewBullet: function(bullet) {
-                var source = 'import QtQuick 2.0; Image {\n' +
-                        'id:' + bullet.id + '\n' +
-                        'source: "image://bulletprovider/' + bullet.direction + '"\n' +
-                        'width: ' + bullet.geometry.width + '\n' +
-                        'height: ' + bullet.geometry.height + '\n' +
-                        'smooth: false\n' +
-                        'x: ' + bullet.geometry.x + '\n' +
-                        'y: ' + bullet.geometry.y + '\n' +
-                        'Behavior on x { NumberAnimation { duration:150 } }\n' +
-                        'Behavior on y { NumberAnimation { duration:150 } }\n' +
-                        'z:50 }';
-                //console.log("New bullet! " + source)
-                var obj = Qt.createQmlObject(source, battleField, "dynamicBullet_" + bullet.id);
-                game.bulletsMap[bullet.id] = obj;
-                game.bulletsList.push(obj)
-
-                shotSound.play();
-            }
-
-            onBulletMoved: function(id, pos) {
-                game.bulletsMap[id].x = pos.x;
-                game.bulletsMap[id].y = pos.y;
+            onFlagChanged: {
+                flag.source = game.flagFile;
             }
 
-            onBulletDetonated: function(id, reason) {
-                switch (reason) {
-                case 0: // no damage
+            onSoundRequested: function(sound) {
+                switch (sound) {
+                case Tanks.ShotSound:
+                    shotSound.play();
+                    break;
+                case Tanks.NoDamageSound:
                     explNoDamageSound.play();
                     break;
-                case 1: // bricks
+                case Tanks.BrickSound:
                     explBrickSound.play();
                     break;
-                case 2: // tank
+                case Tanks.TankSound:
                     explTankSound.play();
                     break;
-                case 3: // flag
+                case Tanks.FlagSound:
                     explFlagSound.play();
                     break;
                 }
-                var obj = game.bulletsMap[id]
-                var index = game.bulletsList.indexOf(obj);
-                game.bulletsList.splice(index,1)
-                delete game.bulletsMap[id]
-                obj.destroy();
             }
 
-            onTankUpdated: function(tank) {
-                //console.log("tank id=" + tank.id + " moved")
-                var old = game.tanksMap[tank.id]
-                if (old === undefined) {
-                    console.log("Something went wrong. tank id=" + tank.id +  " is not found");
-                    return;
-                }
-
-                old.x = tank.geometry.x
-                old.y = tank.geometry.y
-                old.source = 'image://tankprovider/' + tank.affinity +
-                        '/' + tank.variant + '/' + tank.direction + '/' + old.animFrame;
-                old.animFrame = (old.animFrame + 1) % 2;
-                //console.log("x=" + old.x +  " y=" + old.y);
+            onBlockRemoved: function(block) {
+                game.pendingBlockRemove.push(block);
+                lowerLayer.markDirty(block)
+                //console.log("Dirty: " + block);
             }
+        }
 
-            onTankDestroyed: function(id) {
-                var t = game.tanksMap[id]
-
-                game.bigExplosion(t.x, t.y, t.width, t.height, id)
+        // scene objects come from models in C++; rows and their delegates are
+        // reused when objects disappear, inactive ones are just hidden
+        Repeater {
+            model: game.tanks
+            delegate: Image {
+                visible: model.active
+                x: model.x
+                y: model.y
+                width: model.width
+                height: model.height
+                z: 50
+                smooth: false
+                source: "image://tankprovider/" + model.affinity + "/" + model.variant + "/" +
+                        model.direction + "/" + model.frame
+                Behavior on x { enabled: model.active; NumberAnimation { duration:150 } }
+                Behavior on y { enabled: model.active; NumberAnimation { duration:150 } }
+            }
+        }
 
-                var index = game.tanksList.indexOf(t);
-                game.tanksList.splice(index,1)
-                t.destroy()
-                delete game.tanksMap[id]
+        Repeater {
+            model: game.bullets
+            delegate: Image {
+                visible: model.active
+                x: model.x
+                y: model.y
+                width: model.width
+                height: model.height
+                z: 50
+                smooth: false
+                source: "image://bulletprovider/" + model.direction
+                Behavior on x { enabled: model.active; NumberAnimation { duration:150 } }
+                Behavior on y { enabled: model.active; NumberAnimation { duration:150 } }
             }
+        }
 
-            onBlockRemoved: function(block) {
-                game.pendingBlockRemove.push(block);
-                lowerLayer.markDirty(block)
-                //console.log("Dirty: " + block);
+        Repeater {
+            model: game.effects
+            delegate: AnimatedSprite {
+                id: explode
+                property bool active: model.active
+                visible: active
+                z: 200
+                source: "img/explosion1"
+                frameHeight: 16
+                frameWidth: 16
+                frameRate: 6
+                frameCount: 3
+                running: false
+
+                onActiveChanged: {
+                    if (active) {
+                        explode.restart();
+                        grow.restart();
+                    }
+                }
+
+                ParallelAnimation {
+                    id: grow
+                    NumberAnimation { target: explode; property: "x"; from: model.x; to: model.x - model.width; duration: 500 }
+                    NumberAnimation { target: explode; property: "y"; from: model.y; to: model.y - model.height; duration: 500 }
+                    NumberAnimation { target: explode; property: "width"; from: model.width; to: 3 * model.width; duration: 500 }
+                    NumberAnimation { target: explode; property: "height"; from: model.height; to: 3 * model.height; duration: 500 }
+                    onFinished: game.effects.release(index, model.serial)
+                }
             }
         }
 
@@ -278,6 +250,33 @@ Row {
             smooth: false
         }
 
+        // tick profiler overlay, toggled with F3
+        Rectangle {
+            id: profilerOverlay
+            z: 300
+            visible: false
+            color: "#b0000000"
+            width: profilerText.paintedWidth + 10
+            height: profilerText.paintedHeight + 10
+
+            Text {
+                id: profilerText
+                x: 5
+                y: 5
+                color: "lime"
+                font.family: "monospace"
+                font.pointSize: 9
+            }
+
+            Timer {
+                interval: 500
+                repeat: true
+                triggeredOnStart: true
+                running: profilerOverlay.visible
+                onTriggered: profilerText.text = game.profilerReport()
+            }
+        }
+
 
         function handleKeyEvent(event, gameHandler)
         {
@@ -301,6 +300,11 @@ Row {
 
         focus: true
         Keys.onPressed: function(event) {
+            if (event.key === Qt.Key_F3 && !event.isAutoRepeat) {
+                profilerOverlay.visible = !profilerOverlay.visible
+                event.accepted = true
+                return
+            }
             handleKeyEvent(event, game.qmlTankAction)
         }
 
@@ -333,6 +337,16 @@ Row {
                 mouseArea.onClicked: game.restart(2);
             }
 
+            StartButton {
+                // 0 runs as many ticks per frame as fit
+                property var scales: [1, 2, 8, 0]
+                text: game.timeScale > 0 ? "Speed " + game.timeScale + "x" : "Speed max"
+                mouseArea.onClicked: {
+                    var i = scales.indexOf(game.timeScale);
+                    game.timeScale = scales[(i + 1) % scales.length];
+                }
+            }
+
             Text {
                 width: paintedWidth + 20
                 height: paintedHeight + 20
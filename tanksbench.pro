@@ -0,0 +1,31 @@
+# Microbenchmarks of the engine hot paths. Prints JSON and optionally compares
+# it against a stored baseline:
+#   qmake tanksbench.pro && make && ./tanksbench --json current.json --baseline baseline.json
+TEMPLATE = app
+TARGET = tanksbench
+
+QT += qml quick
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+include(tankscore.pri)
+
+SOURCES += logic/bench/benchmain.cpp \
+    logic/bench/benchharness.cpp \
+    logic/bench/allocationcounter.cpp \
+    logic/qml/qmlbridge.cpp \
+    logic/qml/qmltankimageprovider.cpp \
+    logic/qml/qmlmapimageprovider.cpp \
+    logic/qml/qmlentitymodel.cpp
+
+HEADERS += logic/bench/benchharness.h \
+    logic/qml/qmlbridge.h \
+    logic/qml/qmltankimageprovider.h \
+    logic/qml/qmlmapimageprovider.h \
+    logic/qml/qmlentitymodel.h
+
+RESOURCES += render/qml.qrc
+
+INCLUDEPATH += $$PWD/logic/qml $$PWD/logic/bench
+
+include(deployment.pri)
@@ -0,0 +1,57 @@
+# Simulation core shared by the QML application and the headless targets.
+# Everything listed here must build without QtQml/QtQuick.
+
+SOURCES += $$PWD/logic/board.cpp \
+    $$PWD/logic/chunkedmap.cpp \
+    $$PWD/logic/block.cpp \
+    $$PWD/logic/dynamicblock.cpp \
+    $$PWD/logic/entitystore.cpp \
+    $$PWD/logic/gameevents.cpp \
+    $$PWD/logic/staticblock.cpp \
+    $$PWD/logic/bonus.cpp \
+    $$PWD/logic/abstractmaploader.cpp \
+    $$PWD/logic/randommaploader.cpp \
+    $$PWD/logic/game.cpp \
+    $$PWD/logic/tank.cpp \
+    $$PWD/logic/bulletpool.cpp \
+    $$PWD/logic/abstractplayer.cpp \
+    $$PWD/logic/humanplayer.cpp \
+    $$PWD/logic/aiplayer.cpp \
+    $$PWD/logic/ai.cpp \
+    $$PWD/logic/tickprofiler.cpp \
+    $$PWD/logic/tickscheduler.cpp \
+    $$PWD/logic/spatialindex.cpp \
+    $$PWD/logic/slotmap.cpp \
+    $$PWD/logic/flag.cpp
+
+HEADERS += $$PWD/logic/board.h \
+    $$PWD/logic/chunkedmap.h \
+    $$PWD/logic/block.h \
+    $$PWD/logic/dynamicblock.h \
+    $$PWD/logic/entitystore.h \
+    $$PWD/logic/gameevents.h \
+    $$PWD/logic/staticblock.h \
+    $$PWD/logic/bonus.h \
+    $$PWD/logic/abstractmaploader.h \
+    $$PWD/logic/randommaploader.h \
+    $$PWD/logic/game.h \
+    $$PWD/logic/tank.h \
+    $$PWD/logic/bullet.h \
+    $$PWD/logic/bulletpool.h \
+    $$PWD/logic/abstractplayer.h \
+    $$PWD/logic/humanplayer.h \
+    $$PWD/logic/aiplayer.h \
+    $$PWD/logic/ai.h \
+    $$PWD/logic/basics.h \
+    $$PWD/logic/randomstreams.h \
+    $$PWD/logic/tickprofiler.h \
+    $$PWD/logic/tickscheduler.h \
+    $$PWD/logic/spatialindex.h \
+    $$PWD/logic/slotmap.h \
+    $$PWD/logic/flag.h
+
+INCLUDEPATH += $$PWD/logic
+
+# GCC enables loop vectorization only from -O3 on. The word loops of the core
+# are written to vectorize, so turn it on for qmake's default -O2 release builds.
+gcc: QMAKE_CXXFLAGS_RELEASE += -ftree-vectorize
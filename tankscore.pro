@@ -0,0 +1,8 @@
+# Static library with the simulation core only (no QML/Quick).
+TEMPLATE = lib
+TARGET = tankscore
+
+QT = core gui
+CONFIG += c++11 staticlib
+
+include(tankscore.pri)
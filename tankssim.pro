@@ -0,0 +1,22 @@
+# Headless command line simulator. Runs Game::step() back-to-back without
+# a GUI event loop or wall-clock timer.
+TEMPLATE = app
+TARGET = tankssim
+
+QT = core gui
+CONFIG += c++11 console thread
+CONFIG -= app_bundle
+
+SOURCES += logic/headless/simmain.cpp \
+    logic/headless/batchrunner.cpp \
+    logic/headless/workstealingpool.cpp
+
+HEADERS += logic/headless/batchrunner.h \
+    logic/headless/workstealingpool.h
+
+INCLUDEPATH += $$PWD/logic $$PWD/logic/headless
+
+LIBS += -L$$OUT_PWD -ltankscore
+PRE_TARGETDEPS += $$OUT_PWD/$${QMAKE_PREFIX_STATICLIB}tankscore.$${QMAKE_EXTENSION_STATICLIB}
+
+include(deployment.pri)
@@ -0,0 +1,20 @@
+# Unit tests of the simulation core, linked against the tankscore library:
+#   qmake headless.pro && make && make check
+TEMPLATE = app
+TARGET = tankstests
+
+QT = core gui testlib
+CONFIG += c++11 console testcase
+CONFIG -= app_bundle
+
+SOURCES += logic/tests/testmain.cpp \
+    logic/tests/tst_board.cpp \
+    logic/tests/tst_humanplayer.cpp
+
+HEADERS += logic/tests/tst_board.h \
+    logic/tests/tst_humanplayer.h
+
+INCLUDEPATH += $$PWD/logic $$PWD/logic/tests
+
+LIBS += -L$$OUT_PWD -ltankscore
+PRE_TARGETDEPS += $$OUT_PWD/$${QMAKE_PREFIX_STATICLIB}tankscore.$${QMAKE_EXTENSION_STATICLIB}